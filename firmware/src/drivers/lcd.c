@@ -10,144 +10,253 @@
 /** Number of registers that the lcddata spans. */
 #define LCD_NUM_DATA_REGISTERS      24
 
+/**
+ * Hooks to count the work of drawing. The host tests define them to compare
+ * ways of drawing, on the watch they do nothing.
+ * 
+ * LCD_TABLE_READ() wraps every read of a lookup table while drawing, and
+ * LCD_BUFFER_RMW() is run for every read-modify-write of the working buffer.
+*/
+#ifndef LCD_TABLE_READ
+#   define LCD_TABLE_READ(entry)    (entry)
+#endif
+#ifndef LCD_BUFFER_RMW
+#   define LCD_BUFFER_RMW()
+#endif
 
-// Each segment value consists of a high byte representing the LCDDATA register
-// and a low byte representing the bit number of the segment.
 
 /**
- * This matrix holds a value representing each segment's location for the
- * primary 8-character display. The character index starts with the left most
- * position being 1. A blank character is located at index 0.
+ * Segment map of the LCD.
+ * 
+ * Each segment value consists of a high byte representing the LCDDATA register
+ * and a low byte representing the bit number of the segment. This is the only
+ * place the segment locations are described; the lookup tables below are
+ * generated from it for whichever PCB revision we are building for.
 */
-static const unsigned int primary_segments[9][7] = {
-    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
-
 #if (1 == PCB_REV)
-    {0x1704, 0x1705, 0x1105, 0x0B04, 0x0B03, 0x1103, 0x1104},   // 1 Left most
-    {0x1507, 0x0C00, 0x0600, 0x0907, 0x0902, 0x0F02, 0x0F07},   // 2
-    {0x0E07, 0x1201, 0x0C01, 0x0900, 0x0F01, 0x1501, 0x1500},   // 3
-    {0x1203, 0x1204, 0x0C04, 0x0603, 0x0602, 0x0C02, 0x0C03},   // 4
-    {0x1206, 0x1207, 0x0C07, 0x0606, 0x0605, 0x0C05, 0x0C06},   // 5
-    {0x1300, 0x1301, 0x0D01, 0x0700, 0x0906, 0x0F06, 0x0D00},   // 6
-    {0x1303, 0x1505, 0x0F05, 0x0703, 0x0702, 0x0D02, 0x0D03},   // 7
-    {0x1604, 0x1605, 0x1005, 0x0A04, 0x0A06, 0x1006, 0x1004}    // 8 Right most
+
+// Primary characters, segments a-g. 1 is left most, 8 is right most.
+#define LCD_MAP_PRIMARY_1   0x1704, 0x1705, 0x1105, 0x0B04, 0x0B03, 0x1103, 0x1104
+#define LCD_MAP_PRIMARY_2   0x1507, 0x0C00, 0x0600, 0x0907, 0x0902, 0x0F02, 0x0F07
+#define LCD_MAP_PRIMARY_3   0x0E07, 0x1201, 0x0C01, 0x0900, 0x0F01, 0x1501, 0x1500
+#define LCD_MAP_PRIMARY_4   0x1203, 0x1204, 0x0C04, 0x0603, 0x0602, 0x0C02, 0x0C03
+#define LCD_MAP_PRIMARY_5   0x1206, 0x1207, 0x0C07, 0x0606, 0x0605, 0x0C05, 0x0C06
+#define LCD_MAP_PRIMARY_6   0x1300, 0x1301, 0x0D01, 0x0700, 0x0906, 0x0F06, 0x0D00
+#define LCD_MAP_PRIMARY_7   0x1303, 0x1505, 0x0F05, 0x0703, 0x0702, 0x0D02, 0x0D03
+#define LCD_MAP_PRIMARY_8   0x1604, 0x1605, 0x1005, 0x0A04, 0x0A06, 0x1006, 0x1004
+
+// Secondary characters, segments a-g plus 3 extra segments for the .5
+// character. The right character only has 1 extra, so the 2 high are empty.
+#define LCD_MAP_SECONDARY_1 0x0805, 0x0E05, 0x1404, 0x1606, 0x1406, 0x0E06, 0x1405, \
+                            0x0806, 0x1302, 0x0807
+#define LCD_MAP_SECONDARY_2 0x0803, 0x0A07, 0x1007, 0x1607, 0x1403, 0x0E04, 0x0E03, \
+                            0x0804, 0x0000, 0x0000
+
+// Periods 1-8 from the left, then the colon.
+#define LCD_MAP_PERIODS     0x0B05, 0x0901, 0x0601, 0x0604, 0x0607, 0x0701, 0x0905, \
+                            0x0A05, 0x0F00
+
+// Addition, subtraction, multiplication, and division signs.
+#define LCD_MAP_SIGNS       0x1506, 0x1205, 0x1202, 0x1407
+
+// Bell, wave thingy, [O]K, PM, and AM.
+#define LCD_MAP_MISC        0x1102, 0x0B02, 0x1702, 0x1502, 0x1703
 
 #elif (2 == PCB_REV)
-    {0x1500, 0x1501, 0x0F01, 0x0900, 0x0807, 0x0E07, 0x0F00},
-    {0x1705, 0x1104, 0x0B04, 0x0B05, 0x0902, 0x0F02, 0x1105},
-    {0x0D04, 0x1403, 0x0E03, 0x0B02, 0x1103, 0x1703, 0x1702},
-    {0x1404, 0x1701, 0x1101, 0x0804, 0x0805, 0x0E05, 0x0E04},
-    {0x1604, 0x1507, 0x0F07, 0x0A04, 0x0A05, 0x1005, 0x1004},
-    {0x1201, 0x1202, 0x0C02, 0x0601, 0x0600, 0x0C00, 0x0C01},
-    {0x1204, 0x1205, 0x0C05, 0x0604, 0x0603, 0x0C03, 0x0C04},
-    {0x1207, 0x1506, 0x0F06, 0x0607, 0x0606, 0x0C06, 0x0C07}
+
+#define LCD_MAP_PRIMARY_1   0x1500, 0x1501, 0x0F01, 0x0900, 0x0807, 0x0E07, 0x0F00
+#define LCD_MAP_PRIMARY_2   0x1705, 0x1104, 0x0B04, 0x0B05, 0x0902, 0x0F02, 0x1105
+#define LCD_MAP_PRIMARY_3   0x0D04, 0x1403, 0x0E03, 0x0B02, 0x1103, 0x1703, 0x1702
+#define LCD_MAP_PRIMARY_4   0x1404, 0x1701, 0x1101, 0x0804, 0x0805, 0x0E05, 0x0E04
+#define LCD_MAP_PRIMARY_5   0x1604, 0x1507, 0x0F07, 0x0A04, 0x0A05, 0x1005, 0x1004
+#define LCD_MAP_PRIMARY_6   0x1201, 0x1202, 0x0C02, 0x0601, 0x0600, 0x0C00, 0x0C01
+#define LCD_MAP_PRIMARY_7   0x1204, 0x1205, 0x0C05, 0x0604, 0x0603, 0x0C03, 0x0C04
+#define LCD_MAP_PRIMARY_8   0x1207, 0x1506, 0x0F06, 0x0607, 0x0606, 0x0C06, 0x0C07
+
+#define LCD_MAP_SECONDARY_1 0x0703, 0x0D03, 0x1302, 0x1206, 0x1505, 0x0F05, 0x1303, \
+                            0x0905, 0x1203, 0x0704
+#define LCD_MAP_SECONDARY_2 0x0701, 0x0700, 0x0D00, 0x1300, 0x1301, 0x0D02, 0x0D01, \
+                            0x0702, 0x0000, 0x0000
+
+#define LCD_MAP_PERIODS     0x0901, 0x0B03, 0x0803, 0x0B01, 0x0907, 0x0602, 0x0605, \
+                            0x0906, 0x1102
+
+#define LCD_MAP_SIGNS       0x1200, 0x1605, 0x1405, 0x1304
+
+#define LCD_MAP_MISC        0x0E06, 0x0806, 0x1406, 0x1502, 0x1407
 #endif
-};
+
+// Expand a segment map into the arguments of macro.
+#define LCD_MAP(macro, map)         macro(map)
+
 
 /**
- * This matrix holds a value representing each segment's location for the
- * secondary 2.5-character display. The index starts with left character being
- * position 1.
+ * Packed segment location.
+ * The low 3 bits are the bit number of the segment, the high 5 bits are the
+ * LCDDATA register. This lets every location fit in a single byte.
 */
-static const unsigned int secondary_segments[3][10] = {
-    {0x0},                                                      // 0 Blank
+#define LCD_PACK(s)                 ((unsigned char)((((s) >> 8) << 3) | ((s) & 0x07)))
 
-#if (1 == PCB_REV)
+// Pack several segment values at once.
+#define LCD_PACK_4(a, b, c, d)      LCD_PACK(a), LCD_PACK(b), LCD_PACK(c), LCD_PACK(d)
+#define LCD_PACK_5(a, b, c, d, e)   LCD_PACK_4(a, b, c, d), LCD_PACK(e)
+#define LCD_PACK_9(a, b, c, d, e, f, g, h, i)                               \
+    LCD_PACK_5(a, b, c, d, e), LCD_PACK_4(f, g, h, i)
+#define LCD_PACK_10(a, b, c, d, e, f, g, h, i, j)                           \
+    LCD_PACK_9(a, b, c, d, e, f, g, h, i), LCD_PACK(j)
 
-    {0x0805, 0x0E05, 0x1404, 0x1606, 0x1406, 0x0E06, 0x1405,    // 1 Left
-     0x0806, 0x1302, 0x0807},   // 3 extra segments for the .5 character.
-    
-    {0x0803, 0x0A07, 0x1007, 0x1607, 0x1403, 0x0E04, 0x0E03,    // 2 Right
-     0x0804, 0x0000, 0x0000}    // This charcter only has 1 extra, so the
-                                // 2 high bits are empty.
+// Mask of the segments a secondary character has. Missing segments are 0x0000
+// in the map.
+#define LCD_HAS(s, bit)             ((s) ? (1U << (bit)) : 0)
+#define LCD_MASK_10(a, b, c, d, e, f, g, h, i, j)                           \
+    (LCD_HAS(a, 0) | LCD_HAS(b, 1) | LCD_HAS(c, 2) | LCD_HAS(d, 3) |        \
+     LCD_HAS(e, 4) | LCD_HAS(f, 5) | LCD_HAS(g, 6) | LCD_HAS(h, 7) |        \
+     LCD_HAS(i, 8) | LCD_HAS(j, 9))
 
-#elif (2 == PCB_REV)
-    {0x0703, 0x0D03, 0x1302, 0x1206, 0x1505, 0x0F05, 0x1303,
-     0x0905, 0x1203, 0x0704},
+// Decode a packed segment into its register and bit mask.
+#define LCD_PACKED_REG(p)           ((unsigned char)((p) >> 3))
+#define LCD_PACKED_BIT(p)           LCD_TABLE_READ(lcd_bit_masks[(p) & 0x07])
 
-    {0x0701, 0x0700, 0x0D00, 0x1300, 0x1301, 0x0D02, 0x0D01,
-     0x0702, 0x0000, 0x0000}
-#endif
-};
 
 /**
- * This array holds a value representing each segment's location for the
- * punctuation on the display. The index start with the left most period being 1
- * and ending with the colon being 9.
+ * Location of one segment of a primary character, precomputed at build time.
+ * 
+ * Drawing a character clears every segment of it and then sets the ones that
+ * are part of the glyph. The keep mask of the first segment found in each
+ * LCDDATA register clears all of the character's segments in that register in
+ * one go. Segments sharing a register with an earlier segment have a keep mask
+ * of 0xFF and are skipped when clearing.
 */
-static const unsigned int period_segments[10] = {
-    0x0,        // 0 Blank
+typedef struct
+{
+    unsigned char segment;  /**< Packed location of the segment. */
+    unsigned char keep;     /**< And-mask to clear the character. */
+} lcd_glyph_segment_t;
 
-#if (1 == PCB_REV)
-    0x0B05,     // 1 Left most
-    0x0901,     // 2
-    0x0601,     // 3
-    0x0604,     // 4
-    0x0607,     // 5
-    0x0701,     // 6
-    0x0905,     // 7
-    0x0A05,     // 8 Right most
-    0x0F00      // 9th period is the colon.
-
-#elif (2== PCB_REV)
-    0x0901,
-    0x0B03,
-    0x0803,
-    0x0B01,
-    0x0907,
-    0x0602,
-    0x0605,
-    0x0906,
-    0x1102
-#endif
+// Decode a segment value into its register and bit mask.
+#define LCD_SEGMENT_REG(s)          ((unsigned char)((s) >> 8))
+#define LCD_SEGMENT_BIT(s)          ((unsigned char)(1U << ((s) & 0xF)))
+
+// Bit mask of segment s if it is located in the same register as segment r.
+#define LCD_SEGMENT_IN(r, s)        \
+    ((LCD_SEGMENT_REG(r) == LCD_SEGMENT_REG(s)) ? LCD_SEGMENT_BIT(s) : 0)
+
+// And-mask clearing every segment of a character that shares a register with r.
+#define LCD_GLYPH_KEEP(r, a, b, c, d, e, f, g)                              \
+    ((unsigned char)~(LCD_SEGMENT_IN(r, a) | LCD_SEGMENT_IN(r, b) |         \
+                      LCD_SEGMENT_IN(r, c) | LCD_SEGMENT_IN(r, d) |         \
+                      LCD_SEGMENT_IN(r, e) | LCD_SEGMENT_IN(r, f) |         \
+                      LCD_SEGMENT_IN(r, g)))
+
+// Segment s of a character. first is true if no earlier segment of the
+// character is in the same register.
+#define LCD_GLYPH_SEGMENT(s, first, a, b, c, d, e, f, g)                    \
+    {LCD_PACK(s), (first) ? LCD_GLYPH_KEEP(s, a, b, c, d, e, f, g) : 0xFF}
+
+// True if segment s does not share a register with segment r.
+#define LCD_SEGMENT_NOT_IN(r, s)    (LCD_SEGMENT_REG(r) != LCD_SEGMENT_REG(s))
+
+/**
+ * Build the glyph map of a primary character from its 7 segment values.
+*/
+#define LCD_GLYPH(a, b, c, d, e, f, g) {                                    \
+    LCD_GLYPH_SEGMENT(a, 1, a, b, c, d, e, f, g),                           \
+    LCD_GLYPH_SEGMENT(b, LCD_SEGMENT_NOT_IN(a, b),                          \
+                      a, b, c, d, e, f, g),                                 \
+    LCD_GLYPH_SEGMENT(c, LCD_SEGMENT_NOT_IN(a, c) &&                        \
+                         LCD_SEGMENT_NOT_IN(b, c),                          \
+                      a, b, c, d, e, f, g),                                 \
+    LCD_GLYPH_SEGMENT(d, LCD_SEGMENT_NOT_IN(a, d) &&                        \
+                         LCD_SEGMENT_NOT_IN(b, d) &&                        \
+                         LCD_SEGMENT_NOT_IN(c, d),                          \
+                      a, b, c, d, e, f, g),                                 \
+    LCD_GLYPH_SEGMENT(e, LCD_SEGMENT_NOT_IN(a, e) &&                        \
+                         LCD_SEGMENT_NOT_IN(b, e) &&                        \
+                         LCD_SEGMENT_NOT_IN(c, e) &&                        \
+                         LCD_SEGMENT_NOT_IN(d, e),                          \
+                      a, b, c, d, e, f, g),                                 \
+    LCD_GLYPH_SEGMENT(f, LCD_SEGMENT_NOT_IN(a, f) &&                        \
+                         LCD_SEGMENT_NOT_IN(b, f) &&                        \
+                         LCD_SEGMENT_NOT_IN(c, f) &&                        \
+                         LCD_SEGMENT_NOT_IN(d, f) &&                        \
+                         LCD_SEGMENT_NOT_IN(e, f),                          \
+                      a, b, c, d, e, f, g),                                 \
+    LCD_GLYPH_SEGMENT(g, LCD_SEGMENT_NOT_IN(a, g) &&                        \
+                         LCD_SEGMENT_NOT_IN(b, g) &&                        \
+                         LCD_SEGMENT_NOT_IN(c, g) &&                        \
+                         LCD_SEGMENT_NOT_IN(d, g) &&                        \
+                         LCD_SEGMENT_NOT_IN(e, g) &&                        \
+                         LCD_SEGMENT_NOT_IN(f, g),                          \
+                      a, b, c, d, e, f, g)                                  \
+}
+
+/**
+ * This matrix holds the glyph map of each character for the primary
+ * 8-character display. The character index starts with the left most
+ * position being 1. A blank character is located at index 0.
+*/
+static const lcd_glyph_segment_t primary_glyphs[9][7] = {
+    LCD_GLYPH(0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_1),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_2),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_3),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_4),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_5),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_6),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_7),
+    LCD_MAP(LCD_GLYPH, LCD_MAP_PRIMARY_8)
 };
 
 /**
- * This array holds a value representing each segment's location for the
- * operation signs on the display. The addition sign is index 1, the subtraction
- * sign index 2, the multiplication sign index 3, and the division sign index 4.
+ * This matrix holds the packed location of each segment for the secondary
+ * 2.5-character display. The index starts with left character being
+ * position 1.
 */
-static const unsigned int sign_segments[5] = {
-    0x0,
+static const unsigned char secondary_segments[3][10] = {
+    {0x0},                                                      // 0 Blank
+    {LCD_MAP(LCD_PACK_10, LCD_MAP_SECONDARY_1)},                // 1 Left
+    {LCD_MAP(LCD_PACK_10, LCD_MAP_SECONDARY_2)}                 // 2 Right
+};
 
-#if (1 == PCB_REV)
-    0x1506,     // Addition sign
-    0x1205,     // Subtraction sign
-    0x1202,     // Multiplication sign
-    0x1407      // Division sign
+/**
+ * This array holds which segments each character of the secondary display
+ * actually has, as a bit per segment.
+*/
+static const unsigned int secondary_masks[3] = {
+    0x0,                                                        // 0 Blank
+    LCD_MAP(LCD_MASK_10, LCD_MAP_SECONDARY_1),                  // 1 Left
+    LCD_MAP(LCD_MASK_10, LCD_MAP_SECONDARY_2)                   // 2 Right
+};
 
-#elif (2 == PCB_REV)
-    0x1200,
-    0x1605,
-    0x1405,
-    0x1304
-#endif
+/**
+ * This array holds the packed location of each segment for the punctuation on
+ * the display. The index start with the left most period being 1 and ending
+ * with the colon being 9.
+*/
+static const unsigned char period_segments[10] = {
+    0x0,        // 0 Blank
+    LCD_MAP(LCD_PACK_9, LCD_MAP_PERIODS)
 };
 
 /**
- * This array holds a value representing each segment's location for the
- * misc segments on the display. The chime bell is index 1, the alarm wave thing
- * is index 2, the letter K is index 3, PM indicator is index 4, AM indicator
- * is index 5.
- * TODO: Maybe we should make time of day its own set of functions?
+ * This array holds the packed location of each segment for the operation signs
+ * on the display. The addition sign is index 1, the subtraction sign index 2,
+ * the multiplication sign index 3, and the division sign index 4.
 */
-static const unsigned int misc_segments[6] = {
+static const unsigned char sign_segments[5] = {
     0x0,
+    LCD_MAP(LCD_PACK_4, LCD_MAP_SIGNS)
+};
 
-#if (1 == PCB_REV)
-    0x1102,     // Bell
-    0x0B02,     // Wave thingy
-    0x1702,     // [O]K
-    0x1502,     // PM
-    0x1703      // AM
-
-#elif (2 == PCB_REV)
-    0x0E06,
-    0x0806,
-    0x1406,
-    0x1502,
-    0x1407
-#endif
+/**
+ * This array holds the packed location of each segment for the misc segments
+ * on the display. The chime bell is index 1, the alarm wave thing is index 2,
+ * the letter K is index 3, PM indicator is index 4, AM indicator is index 5.
+ * TODO: Maybe we should make time of day its own set of functions?
+*/
+static const unsigned char misc_segments[6] = {
+    0x0,
+    LCD_MAP(LCD_PACK_5, LCD_MAP_MISC)
 };
 
 /**
@@ -165,9 +274,81 @@ static volatile unsigned char *lcd_data = &LCDDATA0;
 */
 static volatile unsigned char lcd_buffer[LCD_NUM_DATA_REGISTERS];
 
+/**
+ * Dirty register bitmask.
+ * Each bit marks a register of the working buffer that has changed since the
+ * last lcd_update(). Register n is bit (n & 7) of byte (n >> 3).
+*/
+static volatile unsigned char lcd_dirty[LCD_NUM_DATA_REGISTERS / 8];
+
+/**
+ * Set by lcd_update_ready() when the working buffer holds a complete screen.
+ * Cleared by any change to the working buffer.
+*/
+static volatile unsigned char lcd_ready = 0;
+
+/**
+ * Blink mask.
+ * Each bit marks a segment that is hidden during the off phase of blinking.
+*/
+static volatile unsigned char lcd_blink_mask[LCD_NUM_DATA_REGISTERS];
+
+/** Set during the off phase of blinking. */
+static volatile unsigned char lcd_blink_off = 0;
+
+/** Set by lcd_blink_toggle() until the next frame shows the new phase. */
+static volatile unsigned char lcd_blink_pending = 0;
+
+/** Power profile applied at the start of the next frame. */
+static volatile unsigned char lcd_power_pending = LCD_POWER_ACTIVE;
+
+/** Power profile the LCD is running with. */
+static unsigned char lcd_power_applied = LCD_POWER_ACTIVE;
+
+/** Prescaler (LCDPS.LP) of each power profile. */
+static const unsigned char lcd_power_prescalers[2] = {
+    0b0101,         // Active: 1:6 for ~40Hz
+    0b1111,         // Idle:   1:16 for ~15Hz
+};
+
+/** Charge pump configuration (LCDVCON1) of each power profile. */
+static const unsigned char lcd_power_pumps[2] = {
+    0b11000000,     // Active: 5v LP mode, 3.78v
+    0b10000111,     // Idle:   3v LP mode, highest output
+};
+
+/** Bit masks indexed by bit number, saves us a variable shift. */
+static const unsigned char lcd_bit_masks[8] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
 
 static void         lcd_segments_enable (void);
 
+/**
+ * Write a register of the working buffer.
+ * The register is only marked dirty if the value actually changed.
+*/
+static void         lcd_buffer_write    (unsigned char reg, unsigned char value);
+
+// Set and clear segment bits in the working buffer.
+#define lcd_buffer_set(reg, mask)   lcd_buffer_write((reg), lcd_buffer[(reg)] | (mask))
+#define lcd_buffer_clear(reg, mask) lcd_buffer_write((reg), lcd_buffer[(reg)] & ~(mask))
+
+/**
+ * Mark a register of the working buffer as changed.
+ * lcd_ready has to be cleared before the register is changed.
+*/
+static void         lcd_buffer_touch    (unsigned char reg);
+
+// Value of a register as it should be shown, with blinking segments hidden
+// during the off phase.
+#define lcd_buffer_shown(reg)                                               \
+    (lcd_blink_off ? (lcd_buffer[(reg)] & ~lcd_blink_mask[(reg)]) : lcd_buffer[(reg)])
+
+/** Add or remove a packed segment from the blink mask. */
+static void         lcd_blink_segment   (unsigned char packed, unsigned char blink);
+
 
 void
 lcd_init (void)
@@ -193,15 +374,15 @@ lcd_init (void)
 
     // Charge pump in 5v LP mode with output set to 3.78v
     //
-    LCDVCON1 = 0b11000000;
+    LCDVCON1 = lcd_power_pumps[LCD_POWER_ACTIVE];
 
-    // Type-A waveform
+    // Type-B waveform, needed for the frame interrupt.
     //
-    LCDPSbits.WFT = 0;
+    LCDPSbits.WFT = 1;
     
     // Configure prescaler 1:6 to give us 40 hz
     //
-    LCDPSbits.LP = 0b0101;
+    LCDPSbits.LP = lcd_power_prescalers[LCD_POWER_ACTIVE];
 
     lcd_segments_clear();
     
@@ -215,58 +396,209 @@ lcd_init (void)
 void
 lcd_update (void)
 {
-    // We start at LCDDATA6 which skips COM0 entirely. This is because COM0 is
-    // not actually used on the LCD, so we can save some time.
+    unsigned char lcddata = 0;
+    unsigned char dirty = 0;
+
+    // Only registers that changed since the last update are written. COM0 is
+    // not actually used on the LCD, so nothing ever dirties LCDDATA0-5.
     //
-    for (int lcddata = 6; lcddata < LCD_NUM_DATA_REGISTERS; lcddata++)
+    for (unsigned char byte = 0; byte < sizeof(lcd_dirty); byte++)
     {
-        lcd_data[lcddata] = lcd_buffer[lcddata];
+        dirty = lcd_dirty[byte];
+        lcd_dirty[byte] = 0;
+
+        for (lcddata = byte << 3; dirty; lcddata++)
+        {
+            if (dirty & 0x01)
+            {
+                lcd_data[lcddata] = lcd_buffer_shown(lcddata);
+            }
+
+            dirty >>= 1;
+        }
     }
 }
 
+unsigned char
+lcd_is_dirty (void)
+{
+    return (lcd_dirty[0] | lcd_dirty[1] | lcd_dirty[2]);
+}
+
+void
+lcd_update_ready (void)
+{
+    lcd_ready = 1;
+}
+
+unsigned char
+lcd_update_frame (void)
+{
+    if (!lcd_write_allowed())
+    {
+        return 0;
+    }
+
+    if (lcd_power_pending != lcd_power_applied)
+    {
+        // Between frames, so no frame is driven with mixed settings.
+        lcd_power_applied = lcd_power_pending;
+        LCDPSbits.LP = lcd_power_prescalers[lcd_power_applied];
+        LCDVCON1 = lcd_power_pumps[lcd_power_applied];
+    }
+
+    if (lcd_ready)
+    {
+        lcd_update();
+        lcd_ready = 0;
+    }
+
+    if (lcd_blink_pending)
+    {
+        lcd_blink_pending = 0;
+
+        // Rewrite only the registers that hold blinking segments.
+        for (unsigned char lcddata = 0; lcddata < LCD_NUM_DATA_REGISTERS; lcddata++)
+        {
+            if (lcd_blink_mask[lcddata])
+            {
+                lcd_data[lcddata] = lcd_buffer_shown(lcddata);
+            }
+        }
+    }
+
+    return 1;
+}
+
+void
+lcd_power_profile (unsigned char profile)
+{
+    lcd_power_pending = profile;
+}
+
+void
+lcd_disable (void)
+{
+    LCDCONbits.LCDEN = 0;
+
+    // Disconnect the charge pump.
+    //
+    LCDVCON2bits.LCDVSRC = 0x0;
+}
+
+void
+lcd_enable (void)
+{
+    // The LCD is not driving anything, so the registers can be written
+    // without waiting for a frame.
+    //
+    lcd_update();
+    lcd_ready = 0;
+
+    LCDVCON2bits.LCDVSRC = 0x6;
+
+    LCDCONbits.LCDEN = 1;
+}
+
 
 // Primary
 
+void
+lcd_primary_glyph (unsigned char position, unsigned char segments)
+{
+    const lcd_glyph_segment_t *glyph = primary_glyphs[position];
+    unsigned char regs[LCD_PRIMARY_CHARACTER_SEGMENTS];
+    unsigned char values[LCD_PRIMARY_CHARACTER_SEGMENTS];
+    unsigned char count = 0;
+    unsigned char slot = 0;
+    unsigned char packed = 0;
+    unsigned char keep = 0;
+
+    // Build the new value of each register the character touches in one pass
+    // over its segments, then write each with a single read-modify-write.
+    //
+    for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+    {
+        packed = LCD_TABLE_READ(glyph[segment].segment);
+        keep = LCD_TABLE_READ(glyph[segment].keep);
+
+        if (0xFF != keep)
+        {
+            // First segment in this register, start from it cleared.
+            slot = count++;
+            regs[slot] = LCD_PACKED_REG(packed);
+            values[slot] = lcd_buffer[regs[slot]] & keep;
+        }
+        else
+        {
+            // An earlier segment already started this register.
+            for (slot = 0; regs[slot] != LCD_PACKED_REG(packed); slot++)
+            {
+            }
+        }
+
+        if (segments & 0x01)
+        {
+            values[slot] |= LCD_PACKED_BIT(packed);
+        }
+        segments >>= 1;
+    }
+
+    for (slot = 0; slot < count; slot++)
+    {
+        lcd_buffer_write(regs[slot], values[slot]);
+    }
+}
+
 void
 lcd_primary_draw (unsigned char position, unsigned char segment)
 {
-    unsigned int  segment_address = primary_segments[position][segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = LCD_TABLE_READ(primary_glyphs[position][segment].segment);
 
-    lcd_buffer[com_byte] |= seg_bit_mask;
+    lcd_buffer_set(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 void
 lcd_primary_clear (unsigned char position, unsigned char segment)
 {
-    unsigned int  segment_address = primary_segments[position][segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
-    lcd_buffer[com_byte] &= ~(seg_bit_mask);
+    unsigned char packed = LCD_TABLE_READ(primary_glyphs[position][segment].segment);
+
+    lcd_buffer_clear(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 
 // Secondary
 
+unsigned int
+lcd_secondary_mask (unsigned char position)
+{
+    return secondary_masks[position];
+}
+
 void
 lcd_secondary_draw (unsigned char position, unsigned char segment)
 {
-    unsigned int  segment_address = secondary_segments[position][segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = secondary_segments[position][segment];
 
-    lcd_buffer[com_byte] |= seg_bit_mask;
+    if (!(secondary_masks[position] & (1U << segment)))
+    {
+        return;
+    }
+
+    lcd_buffer_set(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 void
 lcd_secondary_clear (unsigned char position, unsigned char segment)
 {
-    unsigned int  segment_address = secondary_segments[position][segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = secondary_segments[position][segment];
 
-    lcd_buffer[com_byte] &= ~(seg_bit_mask);
+    if (!(secondary_masks[position] & (1U << segment)))
+    {
+        return;
+    }
+
+    lcd_buffer_clear(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 
@@ -275,21 +607,17 @@ lcd_secondary_clear (unsigned char position, unsigned char segment)
 void
 lcd_period_draw (unsigned char segment)
 {
-    unsigned int  segment_address = period_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = period_segments[segment];
 
-    lcd_buffer[com_byte] |= seg_bit_mask;
+    lcd_buffer_set(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 void
 lcd_period_clear (unsigned char segment)
 {
-    unsigned int  segment_address = period_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
-    
-    lcd_buffer[com_byte] &= ~(seg_bit_mask);
+    unsigned char packed = period_segments[segment];
+
+    lcd_buffer_clear(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 
@@ -298,21 +626,17 @@ lcd_period_clear (unsigned char segment)
 void
 lcd_sign_draw (unsigned char segment)
 {
-    unsigned int  segment_address = sign_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = sign_segments[segment];
 
-    lcd_buffer[com_byte] |= seg_bit_mask;
+    lcd_buffer_set(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 void
 lcd_sign_clear (unsigned char segment)
 {
-    unsigned int  segment_address = sign_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
-    
-    lcd_buffer[com_byte] &= ~(seg_bit_mask);
+    unsigned char packed = sign_segments[segment];
+
+    lcd_buffer_clear(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 
@@ -321,21 +645,86 @@ lcd_sign_clear (unsigned char segment)
 void
 lcd_misc_draw (unsigned char segment)
 {
-    unsigned int  segment_address = misc_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
+    unsigned char packed = misc_segments[segment];
 
-    lcd_buffer[com_byte] |= seg_bit_mask;
+    lcd_buffer_set(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
 }
 
 void
 lcd_misc_clear (unsigned char segment)
 {
-    unsigned int  segment_address = misc_segments[segment];
-    unsigned char com_byte = (segment_address >> 8);
-    unsigned char seg_bit_mask = (unsigned char)(1U << (segment_address & 0xF));
-    
-    lcd_buffer[com_byte] &= ~(seg_bit_mask);
+    unsigned char packed = misc_segments[segment];
+
+    lcd_buffer_clear(LCD_PACKED_REG(packed), LCD_PACKED_BIT(packed));
+}
+
+
+// Blinking
+
+void
+lcd_primary_blink (unsigned char position, unsigned char blink)
+{
+    for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+    {
+        lcd_blink_segment(primary_glyphs[position][segment].segment, blink);
+    }
+}
+
+void
+lcd_secondary_blink (unsigned char position, unsigned char blink)
+{
+    for (unsigned char segment = 0; segment < LCD_SECONDARY_CHARACTER_SEGMENTS; segment++)
+    {
+        if (secondary_masks[position] & (1U << segment))
+        {
+            lcd_blink_segment(secondary_segments[position][segment], blink);
+        }
+    }
+}
+
+void
+lcd_misc_blink (unsigned char segment, unsigned char blink)
+{
+    lcd_blink_segment(misc_segments[segment], blink);
+}
+
+void
+lcd_blink_toggle (void)
+{
+    lcd_blink_off ^= 1;
+    lcd_blink_pending = 1;
+}
+
+void
+lcd_blink_clear (void)
+{
+    for (unsigned char lcddata = 0; lcddata < LCD_NUM_DATA_REGISTERS; lcddata++)
+    {
+        if (lcd_blink_mask[lcddata])
+        {
+            lcd_ready = 0;
+            lcd_blink_mask[lcddata] = 0;
+
+            // Make sure hidden segments are shown on the next update.
+            lcd_buffer_touch(lcddata);
+        }
+    }
+
+    lcd_blink_off = 0;
+    lcd_blink_pending = 0;
+}
+
+unsigned char
+lcd_blink_active (void)
+{
+    unsigned char active = 0;
+
+    for (unsigned char lcddata = 0; lcddata < LCD_NUM_DATA_REGISTERS; lcddata++)
+    {
+        active |= lcd_blink_mask[lcddata];
+    }
+
+    return active;
 }
 
 
@@ -349,6 +738,9 @@ lcd_segments_clear (void)
         lcd_data[lcddata] = 0x0;
         lcd_buffer[lcddata] = 0x0;
     }
+
+    // The LCD matches the buffer again.
+    lcd_dirty[0] = lcd_dirty[1] = lcd_dirty[2] = 0;
 }
 
 void
@@ -359,8 +751,56 @@ lcd_segments_set (void)
         lcd_data[lcddata] = 0xFF;
         lcd_buffer[lcddata] = 0xFF;
     }
+
+    lcd_dirty[0] = lcd_dirty[1] = lcd_dirty[2] = 0;
+}
+
+
+static void
+lcd_buffer_write (unsigned char reg, unsigned char value)
+{
+    LCD_BUFFER_RMW();
+
+    if (lcd_buffer[reg] != value)
+    {
+        // Hold off the frame interrupt first. If the last update was marked
+        // ready, it would otherwise commit the buffer halfway through drawing.
+        lcd_ready = 0;
+        lcd_buffer[reg] = value;
+        lcd_buffer_touch(reg);
+    }
 }
 
+static void
+lcd_buffer_touch (unsigned char reg)
+{
+    lcd_dirty[reg >> 3] |= lcd_bit_masks[reg & 0x07];
+}
+
+static void
+lcd_blink_segment (unsigned char packed, unsigned char blink)
+{
+    unsigned char reg = LCD_PACKED_REG(packed);
+    unsigned char mask = lcd_blink_mask[reg];
+
+    if (blink)
+    {
+        mask |= LCD_PACKED_BIT(packed);
+    }
+    else
+    {
+        mask &= ~LCD_PACKED_BIT(packed);
+    }
+
+    if (lcd_blink_mask[reg] != mask)
+    {
+        lcd_ready = 0;
+        lcd_blink_mask[reg] = mask;
+
+        // The segment may need to be hidden or shown right away.
+        lcd_buffer_touch(reg);
+    }
+}
 
 /**
  * Enable LCD controller segments.
@@ -6,6 +6,14 @@
  * - 1/3 bias
  * - 3.78v drive
  * - 35Hz frame frequency
+ * - Type-B waveform
+ * 
+ * The Type-B waveform gives us the LCD frame interrupt, which is used to write
+ * the working buffer to the LCDDATA registers at the start of a frame instead
+ * of somewhere in the middle of one.
+ * 
+ * The frame frequency and charge pump are set by a power profile, see
+ * lcd_power_profile(). The settings above are the active profile.
 */
 
 #ifndef _lcd_h_
@@ -29,6 +37,46 @@
 #define LCD_MISC                             5
 #define LCD_MISC_SEGMENTS                    5
 
+/**
+ * Check if writes to the LCDDATA registers are currently allowed.
+*/
+#define lcd_write_allowed()             (LCDPSbits.WA)
+
+/**
+ * Enable LCD frame interrupts.
+ * The interrupt is generated at the start of every frame.
+*/
+#define lcd_frame_interrupt_enable()    (PIE8bits.LCDIE = 1)
+
+/**
+ * Disable LCD frame interrupts.
+*/
+#define lcd_frame_interrupt_disable()   (PIE8bits.LCDIE = 0)
+
+/**
+ * Clear LCD frame interrupt flag.
+*/
+#define lcd_frame_interrupt_clear()     (PIR8bits.LCDIF = 0)
+
+/**
+ * LCD power profiles.
+ *
+ * Profile  Frame    Charge pump                LCD current
+ * ACTIVE   ~40Hz    5v range, 3.78v            Reference
+ * IDLE     ~15Hz    3v range, highest output   ~1/3 of active (estimate)
+ *
+ * The idle profile lowers the frame frequency and the charge pump voltage to
+ * save power while nobody is looking. Contrast is a bit lower than active.
+ * Both are switched between frames, see lcd_update_frame().
+ *
+ * The currents have not been measured on a watch yet. The drive current goes
+ * with the frame frequency and the square of the voltage, so the idle figure
+ * is estimated from those. Replace them with measured values when there are
+ * some.
+*/
+#define LCD_POWER_ACTIVE                0
+#define LCD_POWER_IDLE                  1
+
 /**
  * Initialize the LCD driver.
  *
@@ -41,10 +89,79 @@ void        lcd_init            (void);
  * Draw working buffer to screen.
  * 
  * This function should be called after drawing to any segments to update the
- * LCDDATA registers.
+ * LCDDATA registers. Only the registers that changed since the last update
+ * are written.
 */
 void        lcd_update          (void);
 
+/**
+ * Check if the working buffer has changed since the last update.
+ * Drawing a segment that is already drawn does not count as a change.
+ * 
+ * @returns     Non-zero if lcd_update() has anything to write.
+*/
+unsigned char lcd_is_dirty      (void);
+
+/**
+ * Mark the working buffer as ready to be shown.
+ * 
+ * Any change to the working buffer after this call clears the ready state
+ * again, so lcd_update_frame() never shows a half drawn screen.
+*/
+void        lcd_update_ready    (void);
+
+/**
+ * Draw working buffer to screen, synchronized to the LCD frame.
+ * 
+ * This is meant to be called from the LCD frame interrupt. The buffer is only
+ * written if it was marked ready and has not been changed since. A pending
+ * blink toggle is always written.
+ * 
+ * @returns     0 if the LCD is not allowing writes and the update should be
+ *              retried on the next frame, 1 otherwise.
+*/
+unsigned char lcd_update_frame  (void);
+
+/**
+ * Switch to a power profile.
+ * 
+ * Changing the prescaler or charge pump in the middle of a frame would drive
+ * that frame with the wrong timing or voltage, so the profile is applied by
+ * lcd_update_frame() at the start of the next frame. Make sure the frame
+ * interrupt is enabled after calling this.
+ * 
+ * @param[in]   profile     LCD_POWER_ACTIVE or LCD_POWER_IDLE.
+*/
+void        lcd_power_profile   (unsigned char profile);
+
+/**
+ * Turn the LCD off.
+ * 
+ * The LCD module and its charge pump are disabled. Drawing still works, but
+ * only changes the working buffer until the LCD is turned on again.
+*/
+void        lcd_disable         (void);
+
+/**
+ * Turn the LCD back on.
+ * 
+ * Everything drawn while the LCD was off is written in one go before the
+ * module is enabled, so the first frame shows the complete screen.
+*/
+void        lcd_enable          (void);
+
+/**
+ * Draws a whole character to the primary display.
+ * Every segment set in segments is drawn and every other segment of the
+ * character is cleared. Bit 0 of segments is segment A, bit 6 is segment G.
+ * Like the other draw functions, lcd_update() must be called at any point
+ * after this to show the character on screen.
+ * 
+ * @param[in] position  The position of the character on screen.
+ * @param[in] segments  Bitmask of the segments to draw.
+*/
+void        lcd_primary_glyph   (unsigned char position, unsigned char segments);
+
 /**
  * Draws a segment to the primary display.
  * This function does not directly interact with the LCDDATA registers. To
@@ -63,6 +180,15 @@ void        lcd_primary_draw    (unsigned char position, unsigned char segment);
 */
 void        lcd_primary_clear   (unsigned char position, unsigned char segment);
 
+/**
+ * Get the segments a character of the secondary display has.
+ * 
+ * @param[in] position  The position of the character on screen.
+ * 
+ * @returns   A bit for each of the 10 segments, set if the segment exists.
+*/
+unsigned int lcd_secondary_mask (unsigned char position);
+
 /**
  * Draws a segment to the secondary display.
  * This function does not directly interact with the LCDDATA registers. To
@@ -70,7 +196,8 @@ void        lcd_primary_clear   (unsigned char position, unsigned char segment);
  * point after this.
  * 
  * @param[in] position  The position of the character on screen.
- * @param[in] segment   The segment to draw.
+ * @param[in] segment   The segment to draw. Nothing is drawn if the
+ *                      character doesn't have it.
 */
 void        lcd_secondary_draw  (unsigned char position, unsigned char segment);
 /**
@@ -129,6 +256,52 @@ void        lcd_misc_draw       (unsigned char segment);
 */
 void        lcd_misc_clear      (unsigned char segment);
 
+/**
+ * Blink or stop blinking a character of the primary display.
+ * Blinking segments are hidden while the blink is in its off phase. They can
+ * still be drawn and cleared as usual, which changes what is shown during the
+ * on phase.
+ * 
+ * @param[in] position  The position of the character on screen.
+ * @param[in] blink     1 to blink the character, 0 to stop blinking it.
+*/
+void        lcd_primary_blink   (unsigned char position, unsigned char blink);
+
+/**
+ * Blink or stop blinking a character of the secondary display.
+ * 
+ * @param[in] position  The position of the character on screen.
+ * @param[in] blink     1 to blink the character, 0 to stop blinking it.
+*/
+void        lcd_secondary_blink (unsigned char position, unsigned char blink);
+
+/**
+ * Blink or stop blinking a misc segment.
+ * 
+ * @param[in] segment   The segment to blink.
+ * @param[in] blink     1 to blink the segment, 0 to stop blinking it.
+*/
+void        lcd_misc_blink      (unsigned char segment, unsigned char blink);
+
+/**
+ * Switch between the on and off phases of blinking.
+ * This is meant to be called from an interrupt. Only the registers holding
+ * blinking segments are rewritten, on the next lcd_update_frame().
+*/
+void        lcd_blink_toggle    (void);
+
+/**
+ * Stop blinking all segments and show them again.
+*/
+void        lcd_blink_clear     (void);
+
+/**
+ * Check if any segments are blinking.
+ * 
+ * @returns     Non-zero if any segment is set to blink.
+*/
+unsigned char lcd_blink_active  (void);
+
 /**
  * Clears all segments.
  * This clears ALL segments on COM0-3, including unused segments. This is
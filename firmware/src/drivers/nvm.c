@@ -47,6 +47,20 @@ nvm_eeprom_read (unsigned char address)
 
 void
 nvm_eeprom_write (unsigned char address, unsigned char data)
+{
+    nvm_eeprom_write_start(address, data);
+
+    while (NVMCON1bits.WR)
+    {
+        // Wait for write completion.
+    }
+
+    // Disable writes
+    NVMCON1bits.WREN = 0;
+}
+
+void
+nvm_eeprom_write_start (unsigned char address, unsigned char data)
 {
     // Set bit to indicate were writing EEPROM
     NVMCON1bits.NVMREGS = 1;
@@ -63,20 +77,15 @@ nvm_eeprom_write (unsigned char address, unsigned char data)
 
     // Perform unlock sequence, this will also start writing data.
     nvm_unlock();
-
-    while (NVMCON1bits.WR)
-    {
-        // Wait for write completion.
-    }
-
-    // Disable writes
-    NVMCON1bits.WREN = 0;
 }
 
 static void
 nvm_unlock (void)
 {
     // The unlock sequence must not be interrupted, so we disable interrupts.
+    // We might be called from an ISR, so they are only reenabled if they were
+    // enabled to begin with.
+    unsigned char gie = INTCONbits.GIE;
     di();
 
     // Step 1. Write 0x55 to NVMCON2
@@ -90,7 +99,7 @@ nvm_unlock (void)
     NVMCON1bits.WR = 1;
 
     // Unlock sequence complete, we may reenable interrupts.
-    ei();
+    INTCONbits.GIE = gie;
 }
 
 
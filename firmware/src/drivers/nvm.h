@@ -42,6 +42,44 @@ nvm_eeprom_read (unsigned char address);
 void
 nvm_eeprom_write (unsigned char address, unsigned char data);
 
+/**
+ * Start writing a byte of data to EEPROM.
+ * 
+ * This returns as soon as the write has started. The write takes a few
+ * milliseconds, and continues while the CPU sleeps. NVMIF is set once it is
+ * done, after which nvm_eeprom_write_end() should be called.
+ * 
+ * @param[in]   address EEPROM memory address to write.
+ * @param[in]   data    Byte of data to write.
+*/
+void
+nvm_eeprom_write_start (unsigned char address, unsigned char data);
+
+/**
+ * Disable writes after the last write started with nvm_eeprom_write_start().
+*/
+#define nvm_eeprom_write_end()          (NVMCON1bits.WREN = 0)
+
+/**
+ * Check if a write is in progress.
+*/
+#define nvm_busy()                      (NVMCON1bits.WR)
+
+/**
+ * Enable the NVM interrupt, which fires when a write is done.
+*/
+#define nvm_interrupt_enable()          (PIE7bits.NVMIE = 1)
+
+/**
+ * Disable the NVM interrupt.
+*/
+#define nvm_interrupt_disable()         (PIE7bits.NVMIE = 0)
+
+/**
+ * Clear the NVM interrupt flag.
+*/
+#define nvm_interrupt_clear()           (PIR7bits.NVMIF = 0)
+
 #endif
 
 // EOF //
\ No newline at end of file
@@ -4,7 +4,6 @@
 */
 
 #include <xc.h>
-#include <math.h>   // for llroundf()
 
 #include "drivers/timers.h"
 
@@ -77,32 +76,34 @@ pwm_freq_set (unsigned int freq)
     // 1. Timer period
     // 2. Timer prescaler
     //
-    // To calculate the correct values, we start with the lowest available
-    // prescaler (1:1). We then calculate the timer period value for each value
-    // and stop at the first that is within the timer limits. This gives us the
-    // prescale option with the highest resolution available for the frequency.
+    // The datasheet gives us the period as (Fosc / 4 / freq / prescale) - 1.
+    // We work out the timer counts of a full period once, in 1/256ths of a
+    // count so it can still be rounded after dividing by the prescaler. Then
+    // we start with the lowest available prescaler (1:1) and stop at the first
+    // that is within the timer limits. This gives us the prescale option with
+    // the highest resolution available for the frequency.
+
+    if (!freq)
+    {
+        // Error: bad frequency!
+        return;
+    }
+
+    unsigned long counts = (((unsigned long)_XTAL_FREQ / 4) << 8) / freq;
 
-    int timer_period = 0;
     // As prescaler values get lower, it allows higher frequencies.
     //
     for (unsigned char timer_prescale = 0; timer_prescale < 8; timer_prescale++)
     {
-        // Magic formula from the datasheet gives us our timer period.
-        // This takes up about 7% of our flash because of the float arithmetic.
-        //
-        timer_period = (int)lroundf(
-            (1 / ((float)freq) /
-            (4 * (1 / (float)_XTAL_FREQ) * (1 << timer_prescale))) - 1
-        );
+        // Round to the nearest count, each prescale step halves the counts.
+        unsigned long timer_period =
+            ((counts + (0x80UL << timer_prescale)) >> (8 + timer_prescale)) - 1;
 
         if ((0 < timer_period) && (timer_period < 255))
         {
             pwm_frequency = freq;
 
-            pwm_timer_period = (unsigned char)timer_period;
-            timer4_period_set(pwm_timer_period); // TODO: Don't actually set the period registers until we enable.
-            pwm_timer_prescaler = timer_prescale;
-            timer4_prescaler_set(pwm_timer_prescaler); // TODO: Same with prescaler
+            pwm_timer_set((unsigned char)timer_period, timer_prescale); // TODO: Don't actually set the registers until we enable.
             return;
         }
     }
@@ -111,6 +112,15 @@ pwm_freq_set (unsigned int freq)
     // Set some defaults?
 }
 
+void
+pwm_timer_set (unsigned char period, unsigned char prescaler)
+{
+    pwm_timer_period = period;
+    timer4_period_set(pwm_timer_period);
+    pwm_timer_prescaler = prescaler;
+    timer4_prescaler_set(pwm_timer_prescaler);
+}
+
 unsigned int
 pwm_freq_get (void)
 {
@@ -122,7 +132,9 @@ void
 pwm_duty_set (unsigned char duty)
 {
     pwm_duty_ratio = duty; // LOL -- DUTY!
-    pwm_duty_cycle = (unsigned int)lroundf(((float)duty/100) * (4 * (pwm_timer_period + 1)));
+    // The duty cycle register counts in quarters of a timer period, so this is
+    // duty% of 4 * (period + 1) rounded, with the 4 cancelled into the 100.
+    pwm_duty_cycle = (((unsigned int)pwm_timer_period + 1) * duty + 12) / 25;
 
     PWM4DC = (pwm_duty_cycle << 6);
 }
@@ -8,6 +8,41 @@
 #ifndef _pwm_h_
 #define _pwm_h_
 
+/**
+ * Timer period for a frequency with a prescaler (0-7 for 1:1 to 1:128).
+ * This is the formula from the datasheet, rounded to the nearest count.
+*/
+#define PWM_PERIOD_PS(freq, ps)                                             \
+    (((_XTAL_FREQ / 4) + (((unsigned long)(freq) << (ps)) / 2)) /           \
+        ((unsigned long)(freq) << (ps)) - 1)
+
+/**
+ * Timer prescaler for a frequency.
+ * This is the lowest prescaler that fits the period in the timer, which gives
+ * the highest resolution. These are meant for constants, so the calculations
+ * are done at compile time.
+*/
+#define PWM_PRESCALER(freq)                                                 \
+    ((PWM_PERIOD_PS(freq, 0) < 255) ? 0 :                                   \
+     (PWM_PERIOD_PS(freq, 1) < 255) ? 1 :                                   \
+     (PWM_PERIOD_PS(freq, 2) < 255) ? 2 :                                   \
+     (PWM_PERIOD_PS(freq, 3) < 255) ? 3 :                                   \
+     (PWM_PERIOD_PS(freq, 4) < 255) ? 4 :                                   \
+     (PWM_PERIOD_PS(freq, 5) < 255) ? 5 :                                   \
+     (PWM_PERIOD_PS(freq, 6) < 255) ? 6 : 7)
+
+/**
+ * Timer period for a frequency, using PWM_PRESCALER().
+*/
+#define PWM_PERIOD(freq)                                                    \
+    ((unsigned char)PWM_PERIOD_PS(freq, PWM_PRESCALER(freq)))
+
+/**
+ * Duty cycle register value (PWM4DCH) for a frequency and duty percentage.
+*/
+#define PWM_DUTY(freq, duty)                                                \
+    ((unsigned char)((((unsigned int)PWM_PERIOD(freq) + 1) * (duty) + 50) / 100))
+
 /**
  * Initialize the pwm driver for use.
 */
@@ -39,6 +74,19 @@ pwm_freq_set (unsigned int freq);
 unsigned int
 pwm_freq_get (void);
 
+/**
+ * Set the timer period and prescaler directly.
+ * This skips calculating them from a frequency, see PWM_PERIOD() and
+ * PWM_PRESCALER().
+*/
+void
+pwm_timer_set (unsigned char period, unsigned char prescaler);
+
+/**
+ * Set the duty cycle register directly, see PWM_DUTY().
+*/
+#define pwm_duty_raw_set(duty)      (PWM4DCH = (duty), PWM4DCL = 0)
+
 /**
  * Enables the PWM output.
 */
@@ -5,6 +5,8 @@
  * - Timer 0 is used for the main tick timer. This tick drives the main loop to
  *      call a mode at the set tick rate.
  * - Timer 1 is used for button debouncing.
+ * - Timer 2 is used for timeouts. It runs from the 32kHz clock so it keeps
+ *      counting while we sleep.
  * - Timer 4 is used for PWM to drive the buzzer.
 */
 
@@ -46,6 +48,30 @@ timer1_init (void)
     T1CLKbits.CS = 0b0010; // Set clock source to Fosc
 }
 
+void
+timer2_init (void)
+{
+    // Free running with period, software gate.
+    T2HLTbits.MODE = 0b00000;
+
+    // not syncd with Fosc to allow for operation during sleep
+    T2HLTbits.PSYNC = 0;
+    T2HLTbits.CKSYNC = 0;
+
+    // prescaler 1:128, postscaler 1:1
+    T2CONbits.CKPS = 0b111;
+    T2CONbits.OUTPS = 0b0000;
+
+#   if (1 == PCB_REV)
+    // clock src LFINTOSC
+    T2CLKCONbits.CS = 0b0100;
+
+#   else // (2 == PCB_REV)
+    // clock src SOSC
+    T2CLKCONbits.CS = 0b0110;
+#   endif
+}
+
 void
 timer4_init (void)
 {
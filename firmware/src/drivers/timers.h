@@ -3,7 +3,7 @@
  * The timers are used as follows:
  * - timer0: 'tick' interrupt for mode application's tickrate.
  * - timer1:
- * - timer2: PWM3 - Backlight
+ * - timer2: 'timeout' interrupt for delayed callbacks.
  * - timer4: PWM4 - Buzzer
 */
 
@@ -106,6 +106,67 @@ void    timer1_init (void);
 #define timer1_get()        (unsigned)(((TMR1H) << 8) | (TMR1L))
 
 
+/**
+ * Initialize timer2.
+ * This configures timer2 to count in 1:128 of the 32kHz clock, so it can be
+ * used to time things that keep going while we sleep.
+*/
+void    timer2_init (void);
+
+/**
+ * Start timer2.
+*/
+#define timer2_start()      (T2CONbits.ON = 1)
+
+/**
+ * Stop timer2.
+ * The timer value is kept until it is set again.
+*/
+#define timer2_stop()       (T2CONbits.ON = 0)
+
+/**
+ * Set timer2 period value.
+ * An interrupt is generated when the timer counts up to this value, and the
+ * timer starts counting from 0 again.
+*/
+#define timer2_period_set(period)   (T2PR = (period))
+
+/**
+ * Get timer2 period value.
+*/
+#define timer2_period_get()         (T2PR)
+
+/**
+ * Set timer2 value.
+*/
+#define timer2_set(value)           (T2TMR = (value))
+
+/**
+ * Get timer2 value.
+*/
+#define timer2_get()                (T2TMR)
+
+/**
+ * Enable timer2 interrupts.
+*/
+#define timer2_interrupt_enable()   (PIE4bits.TMR2IE = 1)
+
+/**
+ * Disable timer2 interrupts.
+*/
+#define timer2_interrupt_disable()  (PIE4bits.TMR2IE = 0)
+
+/**
+ * Check the timer2 interrupt flag.
+*/
+#define timer2_interrupt_flag()     (PIR4bits.TMR2IF)
+
+/**
+ * Clear timer2 interrupt flag.
+*/
+#define timer2_interrupt_clear()    (PIR4bits.TMR2IF = 0)
+
+
 /**
  * Initialize timer4.
  * This configures timer4 to be used for PWM generation for the buzzer.
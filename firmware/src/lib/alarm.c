@@ -9,6 +9,7 @@
 
 #include "lib/isr.h"
 #include "lib/events.h"
+#include "lib/eeprom.h"
 
 #define LOG_TAG "lib.alarm"
 #include "lib/logging.h"
@@ -16,26 +17,96 @@
 #include "lib/alarm.h"
 
 
+/** Seconds in a day. */
+#define ALARM_DAY_SECONDS       86400UL
+
 /**
- * This array holds the alarms that are currently registered.
+ * Hook run for every step an alarm moves through the heap. The host tests
+ * define it to count the cost of the heap, on the watch it does nothing.
 */
-static datetime_t registered_alarms[ALARM_MAX_ALARMS] = {0};
+#ifndef ALARM_SIFT_STEP
+#   define ALARM_SIFT_STEP()
+#endif
+
+/** A registered alarm. */
+typedef struct
+{
+    unsigned long epoch;        /**< Seconds since 2000 the alarm goes off. */
+    time_t time;                /**< Time of the alarm for the RTCC registers. */
+    unsigned char event_data;
+} alarm_t;
+
+/**
+ * The registered alarms, as a binary min-heap on the epoch seconds. The next
+ * alarm is always at index 0 and the children of index i are at 2i+1 and 2i+2.
+*/
+static alarm_t registered_alarms[ALARM_MAX_ALARMS];
 
 /** Number of currently registered alarms. */
 static volatile unsigned char registered_alarms_count = 0;
 
-/** Index of current registered alarm. */
-static volatile unsigned char registered_alarms_head = 0;
+/** An alarm as it is stored in EEPROM. */
+typedef struct
+{
+    unsigned long epoch;        /**< Seconds since 2000, ALARM_STORE_EMPTY if free. */
+    unsigned char event_data;
+} alarm_stored_t;
+
+/**
+ * Bytes of a stored alarm. The epoch seconds come first with the most
+ * significant byte first, followed by the event data.
+*/
+#define ALARM_STORE_SIZE        5
+
+/** EEPROM address of a slot of the alarm store. */
+#define ALARM_STORE_SLOT(slot)  \
+    (unsigned char)(ALARM_STORE_ADDRESS + ((slot) * ALARM_STORE_SIZE))
 
 /**
- * This inserts an alarm at the given index. Shifts alarms around if needed.
+ * The first byte of a free slot. Epoch seconds don't get that high until
+ * 2135, so it can't be a valid alarm.
 */
-void alarm_insert(unsigned char index, datetime_t *alarm_dt);
+#define ALARM_STORE_FREE        0xFF
+
+/** Epoch of a free slot. */
+#define ALARM_STORE_EMPTY       0xFFFFFFFFUL
+
+/** Copy of the alarm store in EEPROM. */
+static alarm_stored_t alarm_store[ALARM_STORE_SLOTS];
 
 /**
- * Delete an alarm event at a given index. Shifts the the alarms up.
+ * Slot the search for a free slot starts at. It moves past every slot that is
+ * used, so alarms that are set again and again, like the chime, go around all
+ * of the slots instead of wearing out the first one.
 */
-void alarm_delete(unsigned char index);
+static unsigned char alarm_store_next = 0;
+
+/** Set when the registered alarms changed since the last alarm_flush(). */
+static volatile unsigned char alarm_store_dirty = 0;
+
+/** Alarms that went off while we were reset. */
+static alarm_stored_t alarm_missed_alarms[ALARM_STORE_SLOTS];
+
+/** Number of alarms that were missed. */
+static unsigned char alarm_missed_count = 0;
+
+/** Restore the alarms from the store. */
+static void alarm_store_load (void);
+
+/** Register an alarm at the given epoch seconds. */
+static void alarm_add (unsigned long epoch, unsigned char event_data);
+
+/** Remove the alarm at an index of the heap. */
+static void alarm_remove (unsigned char index);
+
+/** Move the alarm at an index up the heap until its parent is earlier. */
+static void alarm_sift_up (unsigned char index);
+
+/** Move the alarm at an index down the heap until its children are later. */
+static void alarm_sift_down (unsigned char index);
+
+/** Set the RTCC alarm registers to the next alarm. */
+static void alarm_registers_set (void);
 
 /** Alarm interrupt service routine. */
 static void alarm_isr (void);
@@ -44,7 +115,6 @@ void
 alarm_init (void)
 {
     registered_alarms_count = 0;
-    registered_alarms_head = 0;
 
     // Set alarm mask to match HH:MM:SS
     rtcc_alarm_mask_set(0b0110);
@@ -54,606 +124,480 @@ alarm_init (void)
 
     // Enable alarm interrupts
     rtcc_alarm_interrupt_enable();
+
+    // Register the alarms we had before the reset.
+    alarm_store_load();
 }
 
 void
 alarm_get (datetime_t *alarm_datetime)
 {
-    *alarm_datetime = registered_alarms[registered_alarms_head];
+    datetime_from_epoch(registered_alarms[0].epoch, alarm_datetime);
+    alarm_datetime->date.weekday = registered_alarms[0].event_data;
 }
 
 void
 alarm_set_time (time_t *alarm_time, unsigned char event_data)
 {
-    // Check if we have a free spot
-    //
-    if ((ALARM_MAX_ALARMS > registered_alarms_count))
-    {
-        // Our datetime object that represents this alarm.
-        datetime_t alarm_dt;
-
-        // Set the time of our alarm.
-        alarm_dt.time = *alarm_time;
-
-        // Populate the alarm with current date.
-        datetime_today(&alarm_dt.date);
-
-        // Figure out true date of alarm.
-        // NOTE: This will make all alarms sort correctly, but what happens
-        // if today is the last day of the month? We work around this currently
-        // by just matching the alarm time and not the date. It has yet to be
-        // determined how this effects midnight rollover.
-        //
-        // A potential bug is when the next alarm to occur is not on the next
-        // day.
-        //
-        // Check to see if time is before right now.
-        if (alarm_time->hour <= HOURS)
-        {
-            if (alarm_time->hour == HOURS)
-            {
-                if (alarm_time->minute <= MINUTES)
-                {
-                    if (alarm_time->minute == MINUTES)
-                    {
-                        if (alarm_time->second <= SECONDS)
-                        {
-                            if (alarm_time->second == SECONDS)
-                            {
-                                // ALARM IS RIGHT NOW! PANIC!
-                                // The caller probably wants it tomorrow?
-                                alarm_dt.date.day += 1;
-                                //Subject to change
-                            }
-                            else
-                            {
-                                // If the alarm second is less than the current
-                                // second, we assume the alarm is for tomorrow.
-                                alarm_dt.date.day += 1;
-                            }
-                        }
-                        else
-                        {
-                            // The alarm is in less than a minute.
-                        }
-                    }
-                    else
-                    {
-                        // If the alarm minute is less than the current minute, we
-                        // assume the alarm is for tomorrow.
-                        alarm_dt.date.day += 1;
-                    }
-                }
-                else
-                {
-                    // The alarm is in less than an hour.
-                }
-            }
-            else
-            {
-                // If the alarm hour is less than the current hour, we assume the
-                // alarm is for tomorrow.
-                alarm_dt.date.day += 1;
-            }
-        }
-        else
-        {
-            // If it is later than the current hour, we assume today.
-        }
-        
-        // Set our datetime
-        alarm_set_datetime(&alarm_dt, event_data);
-    }
-    else
+    datetime_t now;
+    datetime_t alarm_dt;
+    unsigned long now_epoch;
+    unsigned long alarm_epoch;
+
+    // The alarm is today at the given time.
+    datetime_now(&now);
+    alarm_dt.date = now.date;
+    alarm_dt.time = *alarm_time;
+
+    now_epoch = datetime_epoch(&now);
+    alarm_epoch = datetime_epoch(&alarm_dt);
+
+    // If that time has already occurred today (or is right now), the caller
+    // wants it tomorrow.
+    if (alarm_epoch <= now_epoch)
     {
-        // Max alarms have been added
-        LOG_ERROR("Max alarms added: %.2i:%.2i:%.2i",
-            BCD2DEC(alarm_time->hour),
-            BCD2DEC(alarm_time->minute),
-            BCD2DEC(alarm_time->second)
-        );
+        alarm_epoch += ALARM_DAY_SECONDS;
     }
+
+    alarm_add(alarm_epoch, event_data);
 }
 
 void
 alarm_set_datetime (datetime_t *alarm_datetime, unsigned char event_data)
 {
-    // Check if we have a free spot
-    //
-    if ((ALARM_MAX_ALARMS > registered_alarms_count))
-    {
-        // TODO: Verify alarm is within bounds of time:
-        // - Hour     0-23
-        // - Minute   0-59
-        // - Seconds  0-59
-
-        // We store the event data in the weekday field
-        alarm_datetime->date.weekday = event_data;
-
-        int alarm_index = -1;
-        unsigned char alarm_position = 0;
-        
-        // Loop through the list of registered alarms and compare.
-        // Right now we only compare up to the day, so monthly alarms might now
-        // work correctly.
-        for (unsigned char c = 0; c < registered_alarms_count; c++)
-        {
-            // Loop from head to tail based on the head and the length
-            unsigned char i = (registered_alarms_head + c) % ALARM_MAX_ALARMS;
-            alarm_position = c;
+    // TODO: Verify alarm is within bounds of time:
+    // - Hour     0-23
+    // - Minute   0-59
+    // - Seconds  0-59
 
-            if (alarm_datetime->date.day < registered_alarms[i].date.day)
-            {
-                // This is our alarm index
-                alarm_index = i;
-                break;
-            }
-            else if (alarm_datetime->date.day == registered_alarms[i].date.day)
-            {
-                // If the day is the same, compare the times.
-
-                if (alarm_datetime->time.hour < registered_alarms[i].time.hour)
-                {
-                    // This is our alarm index
-                    alarm_index = i;
-                    break;
-                }
-                else if (alarm_datetime->time.hour == registered_alarms[i].time.hour)
-                {
-                    // If the hour is the same, compare the minute.
-
-                    if (alarm_datetime->time.minute < registered_alarms[i].time.minute)
-                    {
-                        // This is our alarm index
-                        alarm_index = i;
-                        break;
-                    }
-                    else if (alarm_datetime->time.minute == registered_alarms[i].time.minute)
-                    {
-                        // If the minute is the same, compare the seconds.
-
-                        if (alarm_datetime->time.second < registered_alarms[i].time.second)
-                        {
-                            // This is our alarm index
-                            alarm_index = i;
-                            break;
-                        }
-                        else if (alarm_datetime->time.second == registered_alarms[i].time.second)
-                        {
-                            // An alarm with that time is already registered.
-                            // Check if this is the last registered alarm.
-                            if ((c+1) == registered_alarms_count)
-                            {
-                                LOG_WARNING("Duplicate alarm added: %.2i:%.2i:%.2i",
-                                    BCD2DEC(alarm_datetime->time.hour),
-                                    BCD2DEC(alarm_datetime->time.minute),
-                                    BCD2DEC(alarm_datetime->time.second)
-                                );
-                                // This is our alarm index
-                                alarm_index = i+1;
-                                alarm_position++;
-                                break;
-                            }
-                        }
-                        else
-                        {
-                            // Alarm is after this index
-
-                            // Check if this is the last registered alarm.
-                            if ((c+1) == registered_alarms_count)
-                            {
-                                // This is our alarm index
-                                alarm_index = i+1;
-                                alarm_position++;
-                                break;
-                            }
-                        }   
-                    }
-                    else
-                    {
-                        // Alarm is after this index
-
-                        // Check if this is the last registered alarm.
-                        if ((c+1) == registered_alarms_count)
-                        {
-                            // This is our alarm index
-                            alarm_index = i+1;
-                            alarm_position++;
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    // Alarm is after this index
-
-                    // Check if this is the last registered alarm.
-                    if ((c+1) == registered_alarms_count)
-                    {
-                        // This is our alarm index
-                        alarm_index = i+1;
-                        alarm_position++;
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                // Alarm is after this index
-
-                // Check if this is the last registered alarm.
-                if ((c+1) == registered_alarms_count)
-                {
-                    // This is our alarm index
-                    alarm_index = i+1;
-                    alarm_position++;
-                    break;
-                }
-            }
-        }
+    // We store the event data in the weekday field
+    alarm_datetime->date.weekday = event_data;
 
-        // Make sure our alarm index has been set in the spaghetti above.
-        if (-1 == alarm_index)
-        {
-            // Check if we have any alarms registered
-            if (0 == registered_alarms_count)
-            {
-                // Alarm is the only registered alarm
-                alarm_index = registered_alarms_head;
-            }
-            else
-            {
-                // We should never get here
-                LOG_ERROR("Couldn't register alarm!");
-                return;
-            }
-        }
-
-        // Handle tail wrapping
-        alarm_index = alarm_index % ALARM_MAX_ALARMS;
-
-        // Insert our alarm into the list.
-        alarm_insert((unsigned char)alarm_index, alarm_datetime);
-
-        // rtcc_alarm_interrupt_enable();
-        // LOG_DEBUG("ALARM: %x %x %x", ALRMCON, ALRMRPT, PIE8);
-
-        LOG_INFO("Registered alarm [%i] (%i/%i) %.2i:%.2i:%.2i %.2i/%.2i x%.2X%.2X",
-            alarm_index,
-            alarm_position+1,
-            registered_alarms_count,
-            BCD2DEC(alarm_datetime->time.hour),
-            BCD2DEC(alarm_datetime->time.minute),
-            BCD2DEC(alarm_datetime->time.second),
-            BCD2DEC(alarm_datetime->date.month),
-            BCD2DEC(alarm_datetime->date.day),
-            alarm_datetime->date.weekday,
-            ALARM_EVENT
-        );
-    }
-    else
-    {
-        // Max alarms have been added
-        LOG_ERROR("Max alarms added: %.2i:%.2i:%.2i",
-            BCD2DEC(alarm_datetime->time.hour),
-            BCD2DEC(alarm_datetime->time.minute),
-            BCD2DEC(alarm_datetime->time.second)
-        );
-    }
+    alarm_add(datetime_epoch(alarm_datetime), event_data);
 }
 
 unsigned char
 alarm_del_event (unsigned char event_data)
 {
     unsigned char deleted_alarms = 0;
+    unsigned char head_event = registered_alarms[0].event_data;
 
-    // Loop through the registered_alarm list and remove alarms that have the
-    // specified event_data. The event_data is stored in the weekday field.
+    // Keep the ISR from consuming alarms while we change the heap.
+    rtcc_alarm_interrupt_disable();
 
-    for (unsigned char c = 0; c < registered_alarms_count; c++)
+    // Search from the end of the heap. A removed alarm is replaced by the
+    // last alarm or one of its parents, so the same index is checked again.
+    for (unsigned char i = registered_alarms_count; i > 0; )
     {
-        // Loop from head to tail based on the head and the length
-        unsigned char i = (registered_alarms_head + c) % ALARM_MAX_ALARMS;
-
-        if (event_data == registered_alarms[i].date.weekday)
+        if (event_data == registered_alarms[i-1].event_data)
         {
             LOG_DEBUG("Removing alarm: (x%.2X) %.2i:%.2i",
-                registered_alarms[i].date.weekday,
-                BCD2DEC(registered_alarms[i].time.hour),
-                BCD2DEC(registered_alarms[i].time.minute)
+                registered_alarms[i-1].event_data,
+                BCD2DEC(registered_alarms[i-1].time.hour),
+                BCD2DEC(registered_alarms[i-1].time.minute)
             );
 
             // Remove alarm
-            alarm_delete(i);
+            alarm_remove(i-1);
             deleted_alarms++;
+            alarm_store_dirty = 1;
 
-            // Resume search from previous index
-            c--;
+            if (i > registered_alarms_count)
+            {
+                i--;
+            }
+        }
+        else
+        {
+            i--;
         }
     }
 
+    // The next alarm changed if it was one of the deleted alarms.
+    if (deleted_alarms && (event_data == head_event))
+    {
+        if (registered_alarms_count)
+        {
+            alarm_registers_set();
+        }
+        else
+        {
+            rtcc_writes_enable();
+            rtcc_alarm_disable();
+            rtcc_writes_disable();
+        }
+    }
+
+    rtcc_alarm_interrupt_enable();
+
     return deleted_alarms;
 }
 
-void
-alarm_delete (unsigned char index)
+unsigned char
+alarm_find_event (unsigned char event_data, datetime_t *alarm_datetime)
 {
-    // Bail early if the index is not in the range of registered alarms.
-    if (!(((index >= registered_alarms_head) && (index-registered_alarms_head <= registered_alarms_count)) ||
-        ((index < registered_alarms_head) && (index < (registered_alarms_head+registered_alarms_count)%ALARM_MAX_ALARMS))))
+    for (unsigned char i = 0; i < registered_alarms_count; i++)
+    {
+        if (event_data == registered_alarms[i].event_data)
         {
-            LOG_ERROR("Alarm is out of bounds!");
-            return;
+            datetime_from_epoch(registered_alarms[i].epoch, alarm_datetime);
+            alarm_datetime->date.weekday = event_data;
+            return 1;
         }
+    }
 
-    // Shift up all alarms that are:
-    // 1) Behind the head
-    // 2) Behind the index
-    // 3) Before the end of the buffer (no wrapping)
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    //    shift left ^ ^ ^
+    return 0;
+}
 
-    if (index >= registered_alarms_head)
+unsigned char
+alarm_missed (unsigned char event_data, datetime_t *alarm_datetime)
+{
+    for (unsigned char m = 0; m < alarm_missed_count; m++)
     {
-        for (unsigned char i = index+1; i < ALARM_MAX_ALARMS; i++)
+        if (event_data == alarm_missed_alarms[m].event_data)
         {
-            // Shift each time and date to the previous position
-            registered_alarms[i-1].time = registered_alarms[i].time;
-            registered_alarms[i-1].date = registered_alarms[i].date;
+            datetime_from_epoch(alarm_missed_alarms[m].epoch, alarm_datetime);
+            return 1;
         }
     }
 
+    return 0;
+}
 
-    // Next, handle the wrapping of the circular buffer if needed
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    // > (if count > 6)  ^
-
-    if ((index >= registered_alarms_head) && (registered_alarms_head+registered_alarms_count > ALARM_MAX_ALARMS))
+void
+alarm_flush (void)
+{
+    // Snapshot of the registered alarms.
+    static unsigned long epochs[ALARM_STORE_SLOTS];
+    static unsigned char events[ALARM_STORE_SLOTS];
+    static unsigned char stored[ALARM_STORE_SLOTS];
+    unsigned char count;
+    unsigned char c;
+    unsigned char slot;
+
+    if (!alarm_store_dirty)
     {
-        // Shift index 0 to the last index
-        registered_alarms[ALARM_MAX_ALARMS-1].time = registered_alarms[0].time;
-        registered_alarms[ALARM_MAX_ALARMS-1].date = registered_alarms[0].date;
+        return;
+    }
 
-        // Set index to 0
-        // This will shift all alarms from index 1 until the tail in the next loop
-        index = 0;
+    // Keep the ISR from consuming alarms while we copy them.
+    rtcc_alarm_interrupt_disable();
+    alarm_store_dirty = 0;
+    count = registered_alarms_count;
+    if (count > ALARM_STORE_SLOTS)
+    {
+        // The top of the heap is kept, which always holds the next alarm.
+        LOG_WARNING("Storing %i of %i alarms", ALARM_STORE_SLOTS, count);
+        count = ALARM_STORE_SLOTS;
+    }
+    for (c = 0; c < count; c++)
+    {
+        epochs[c] = registered_alarms[c].epoch;
+        events[c] = registered_alarms[c].event_data;
+        stored[c] = 0;
     }
+    rtcc_alarm_interrupt_enable();
 
+    // Alarms that are already stored keep their slot, the others are freed.
+    for (slot = 0; slot < ALARM_STORE_SLOTS; slot++)
+    {
+        if (ALARM_STORE_EMPTY == alarm_store[slot].epoch)
+        {
+            continue;
+        }
 
-    // Finally, shift the alarms at the beginning (end):
-    // 1) Before the head
-    // 2) Before the tail
-    // 3) Behind the index
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    //   ^ ^ ^ shift left                  ^ ^ shift left
+        for (c = 0; c < count; c++)
+        {
+            if (!stored[c]
+                && (epochs[c] == alarm_store[slot].epoch)
+                && (events[c] == alarm_store[slot].event_data))
+            {
+                stored[c] = 1;
+                break;
+            }
+        }
 
-    if (registered_alarms_head+registered_alarms_count > ALARM_MAX_ALARMS)
-    {
-        for (unsigned char i = index+1; i < (registered_alarms_head+registered_alarms_count)%ALARM_MAX_ALARMS; i++)
+        if (c == count)
         {
-            // Shift each time and date to the previous position
-            registered_alarms[i-1].time = registered_alarms[i].time;
-            registered_alarms[i-1].date = registered_alarms[i].date;
+            eeprom_write(ALARM_STORE_SLOT(slot), ALARM_STORE_FREE);
+            alarm_store[slot].epoch = ALARM_STORE_EMPTY;
         }
     }
 
-    // Decrement alarm count
-    registered_alarms_count--;
+    // New alarms go into the free slots. There's a slot for every alarm.
+    slot = alarm_store_next;
+    for (c = 0; c < count; c++)
+    {
+        if (stored[c])
+        {
+            continue;
+        }
+
+        while (ALARM_STORE_EMPTY != alarm_store[slot].epoch)
+        {
+            slot = (slot + 1) % ALARM_STORE_SLOTS;
+        }
 
+        alarm_store[slot].epoch = epochs[c];
+        alarm_store[slot].event_data = events[c];
+
+        // The first byte goes last, the slot stays free until it's written.
+        eeprom_write(ALARM_STORE_SLOT(slot) + 1, (unsigned char)(epochs[c] >> 16));
+        eeprom_write(ALARM_STORE_SLOT(slot) + 2, (unsigned char)(epochs[c] >> 8));
+        eeprom_write(ALARM_STORE_SLOT(slot) + 3, (unsigned char)epochs[c]);
+        eeprom_write(ALARM_STORE_SLOT(slot) + 4, events[c]);
+        eeprom_write(ALARM_STORE_SLOT(slot), (unsigned char)(epochs[c] >> 24));
+
+        alarm_store_next = (slot + 1) % ALARM_STORE_SLOTS;
+    }
 }
 
-void
-alarm_insert (unsigned char index, datetime_t *alarm_dt)
+
+static void
+alarm_store_load (void)
 {
-    // Shift down all alarms that are:
-    // 1) Before the head
-    // 2) Behind the index (in order)
-    // 3) Before the tail
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    // ^ ^ ^ right shift                 ^ ^ right shift
-
-    if (registered_alarms_head+registered_alarms_count > ALARM_MAX_ALARMS) // Check if the buffer wraps around
+    datetime_t now;
+    unsigned long now_epoch;
+    unsigned char address;
+
+    datetime_now(&now);
+    now_epoch = datetime_epoch(&now);
+
+    alarm_missed_count = 0;
+
+    for (unsigned char slot = 0; slot < ALARM_STORE_SLOTS; slot++)
     {
-        unsigned char start;
-        if (index >= registered_alarms_head)
+        address = ALARM_STORE_SLOT(slot);
+
+        if (ALARM_STORE_FREE == eeprom_read(address))
         {
-            start = 0; // If index is behind the head, shift all of the alarms
-        } else {
-            start = index; // Else shift until the index
+            alarm_store[slot].epoch = ALARM_STORE_EMPTY;
+            continue;
         }
-        for (unsigned char i = (registered_alarms_head+registered_alarms_count)%ALARM_MAX_ALARMS;i > start; i--)
+
+        alarm_store[slot].epoch = ((unsigned long)eeprom_read(address) << 24)
+            | ((unsigned long)eeprom_read(address + 1) << 16)
+            | ((unsigned int)eeprom_read(address + 2) << 8)
+            | eeprom_read(address + 3);
+        alarm_store[slot].event_data = eeprom_read(address + 4);
+
+        // After a power on reset the RTCC starts over from a default date, so
+        // alarms can't be told apart from ones that went off while we were
+        // reset. All of them count as missed then.
+        if (datetime_is_set() && (alarm_store[slot].epoch > now_epoch))
         {
-            // Shift each time and date to the following position
-            registered_alarms[i].time = registered_alarms[i-1].time;
-            registered_alarms[i].date = registered_alarms[i-1].date;
+            alarm_add(alarm_store[slot].epoch, alarm_store[slot].event_data);
+        }
+        else
+        {
+            // It went off while we were reset. The slot is freed by the next
+            // alarm_flush().
+            alarm_missed_alarms[alarm_missed_count++] = alarm_store[slot];
+            alarm_store_dirty = 1;
         }
     }
 
-
-    // Next, handle the wrapping of the circular buffer if needed
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    // ^ (if count > 6) <<
-
-    if ((index >= registered_alarms_head) && (registered_alarms_head+registered_alarms_count > ALARM_MAX_ALARMS))
+    if (alarm_missed_count)
     {
-        // Shift the last index to index 0
-        registered_alarms[0].time = registered_alarms[ALARM_MAX_ALARMS-1].time;
-        registered_alarms[0].date = registered_alarms[ALARM_MAX_ALARMS-1].date;
+        LOG_INFO("Missed %i alarms", alarm_missed_count);
+        event_isr((unsigned int)EVENT_ID(ALARM_EVENT, ALARM_EVENT_MISSED));
     }
+}
 
+static void
+alarm_add (unsigned long epoch, unsigned char event_data)
+{
+    datetime_t alarm_dt;
+    unsigned char index;
 
-    // Finally, shift the alarms at the end (beginning):
-    // 1) After the head
-    // 2) Before the end of the buffer
-    // 3) Behind the index
-    //
-    //    head v   v index         index v     v head
-    // 0 1 2 3 4 5 6 7 8 9           0 1 2 3 4 5 6 7 8 9
-    // shift right ^ ^ ^
-
-    if (index >= registered_alarms_head)
+    // Check if we have a free spot
+    if (ALARM_MAX_ALARMS <= registered_alarms_count)
     {
-        for (unsigned char i = ALARM_MAX_ALARMS-1; i > index; i--)
-        {
-            // Shift each time and date to the following position
-            registered_alarms[i].time = registered_alarms[i-1].time;
-            registered_alarms[i].date = registered_alarms[i-1].date;
-        }
+        // Max alarms have been added
+        datetime_from_epoch(epoch, &alarm_dt);
+        LOG_ERROR("Max alarms added: %.2i:%.2i:%.2i",
+            BCD2DEC(alarm_dt.time.hour),
+            BCD2DEC(alarm_dt.time.minute),
+            BCD2DEC(alarm_dt.time.second)
+        );
+        return;
     }
 
-    // After shift the alarms around we can insert it at the position
-    registered_alarms[index] = *alarm_dt;
+    // The time for the RTCC registers comes from the epoch, so dates that
+    // run past the end of a month are taken care of.
+    datetime_from_epoch(epoch, &alarm_dt);
 
-    // Increment alarm count
-    registered_alarms_count++;
+    // Keep the ISR from consuming alarms while we change the heap.
+    rtcc_alarm_interrupt_disable();
+
+    index = registered_alarms_count++;
+    registered_alarms[index].epoch = epoch;
+    registered_alarms[index].time = alarm_dt.time;
+    registered_alarms[index].event_data = event_data;
+    alarm_sift_up(index);
 
     // If the alarm is going to happen the soonest (head), then set the
     // alarm registers.
-    if (index == registered_alarms_head)
+    if (epoch == registered_alarms[0].epoch)
     {
-        // LOG_DEBUG("Setting alarm HEAD");
+        alarm_registers_set();
+    }
 
-        // Enable RTCC writes (for alarm enable bit)
-        rtcc_writes_enable();
+    alarm_store_dirty = 1;
 
-        // Disable alarm to change registers
-        rtcc_alarm_disable();
+    rtcc_alarm_interrupt_enable();
 
-        // Set Registers
-        // ALRMDAY = registered_alarms[0].date.day;
-        ALRMHR  = registered_alarms[index].time.hour;
-        ALRMMIN = registered_alarms[index].time.minute;
-        if (0 == (registered_alarms[index].time.second & 0x0F))
-        {
-            // if (0 == registered_alarms[index].time.second)
-            // {
-            //     ALRMSEC = 0x5A;
-            //     ALRMMIN = DEC2BCD(BCD2DEC(registered_alarms[index].time.minute) - 1);
-            // }
-            // else
-            // {
-            //     ALRMSEC = (((registered_alarms[index].time.second >> 4) - 1) << 4 | 0xA);
-            // }
-            ALRMSEC = registered_alarms[index].time.second + 1;
-        }
-        else
-        {
-            ALRMSEC = registered_alarms[index].time.second;
-        }
+    LOG_INFO("Registered alarm (%i) %.2i:%.2i:%.2i %.2i/%.2i x%.2X%.2X",
+        registered_alarms_count,
+        BCD2DEC(alarm_dt.time.hour),
+        BCD2DEC(alarm_dt.time.minute),
+        BCD2DEC(alarm_dt.time.second),
+        BCD2DEC(alarm_dt.date.month),
+        BCD2DEC(alarm_dt.date.day),
+        event_data,
+        ALARM_EVENT
+    );
+}
 
-        // Enable alarm
-        rtcc_alarm_enable();
+static void
+alarm_remove (unsigned char index)
+{
+    registered_alarms_count--;
 
-        // Disable writes
-        rtcc_writes_disable();
+    if (index == registered_alarms_count)
+    {
+        // It was the last alarm, nothing to move.
+        return;
     }
-}
 
+    // Move the last alarm into the hole. It can belong above or below it.
+    registered_alarms[index] = registered_alarms[registered_alarms_count];
+    if (index && (registered_alarms[index].epoch
+        < registered_alarms[(index - 1) / 2].epoch))
+    {
+        alarm_sift_up(index);
+    }
+    else
+    {
+        alarm_sift_down(index);
+    }
+}
 
 static void
-alarm_isr (void)
+alarm_sift_up (unsigned char index)
 {
-    // Alarm at head has occurred. alarm is disabled.
-    // rtcc_alarm_disable();
-
-    unsigned char consumed_alarms = 1;
-    // Emit event of alarm that triggered interrupt
-    event_isr((unsigned)
-        EVENT_ID(
-            ALARM_EVENT,
-            registered_alarms[registered_alarms_head].date.weekday)
-    );
-    // Match all alarms and emit events
-    for (unsigned char c = 1; c < registered_alarms_count; c++)
+    alarm_t alarm = registered_alarms[index];
+
+    while (index)
     {
-        // Loop from head to tail based on the head and the length
-        unsigned char i = (registered_alarms_head + c) % ALARM_MAX_ALARMS;
+        unsigned char parent = (index - 1) / 2;
 
-        if (registered_alarms[registered_alarms_head].time.second >= registered_alarms[i].time.second)
+        ALARM_SIFT_STEP();
+
+        if (registered_alarms[parent].epoch <= alarm.epoch)
         {
-            if (registered_alarms[registered_alarms_head].time.minute >= registered_alarms[i].time.minute)
-            {
-                if (registered_alarms[registered_alarms_head].time.hour >= registered_alarms[i].time.hour)
-                {
-                    if (registered_alarms[registered_alarms_head].date.day >= registered_alarms[i].date.day)
-                    {
-                        if (registered_alarms[registered_alarms_head].date.month >= registered_alarms[i].date.month)
-                        {
-                            if (registered_alarms[registered_alarms_head].date.year >= registered_alarms[i].date.year)
-                            {
-                                // Alarm matches
-                                consumed_alarms++;
-                                // Emit event
-                                event_isr((unsigned)
-                                    EVENT_ID(
-                                        ALARM_EVENT,
-                                        registered_alarms[i].date.weekday)
-                                );
-                            } else {
-                                break;
-                            }
-                        } else {
-                            break;
-                        }
-                    } else {
-                        break;
-                    }
-                } else {
-                    break;
-                }
-            } else {
-                break;
-            }
-        } else {
             break;
         }
+
+        registered_alarms[index] = registered_alarms[parent];
+        index = parent;
     }
 
-    // Consume alarm(s)
-    registered_alarms_head = (registered_alarms_head + consumed_alarms) % ALARM_MAX_ALARMS;
+    registered_alarms[index] = alarm;
+}
 
-    // Decrement count of registered alarms
-    registered_alarms_count -= consumed_alarms;
+static void
+alarm_sift_down (unsigned char index)
+{
+    alarm_t alarm = registered_alarms[index];
 
-    // Check if we have any alarms registered
-    if (registered_alarms_count)
+    for (;;)
     {
-        // Set alarm registers with head values.
-        ALRMHR  = registered_alarms[registered_alarms_head].time.hour;
-        ALRMMIN = registered_alarms[registered_alarms_head].time.minute;
-        if (0 == (registered_alarms[registered_alarms_head].time.second & 0x0F))
+        // Wide enough for the children of the last index.
+        unsigned int child = (unsigned int)index * 2 + 1;
+
+        ALARM_SIFT_STEP();
+
+        if (child >= registered_alarms_count)
         {
-            // if (0 == registered_alarms[registered_alarms_head].time.second)
-            // {
-            //     ALRMSEC = 0x5A;
-            //     ALRMMIN = DEC2BCD(BCD2DEC(registered_alarms[registered_alarms_head].time.minute) - 1);
-            // }
-            // else
-            // {
-            //     ALRMSEC = (((registered_alarms[registered_alarms_head].time.second >> 4) - 1) << 4 | 0xA);
-            //     // ALRMSEC = ((registered_alarms[registered_alarms_head].time.second & 0xF0) | 0xA);
-            // }
-            ALRMSEC = registered_alarms[registered_alarms_head].time.second + 1;
+            break;
         }
-        else
+
+        // Pick the earlier child.
+        if ((child + 1 < registered_alarms_count)
+            && (registered_alarms[child + 1].epoch < registered_alarms[child].epoch))
         {
-            ALRMSEC = registered_alarms[registered_alarms_head].time.second;
+            child++;
         }
-        
-        // Enable alarm (write enable required)
-        rtcc_writes_enable();
-        rtcc_alarm_enable();
-        rtcc_writes_disable();
+
+        if (alarm.epoch <= registered_alarms[child].epoch)
+        {
+            break;
+        }
+
+        registered_alarms[index] = registered_alarms[child];
+        index = (unsigned char)child;
+    }
+
+    registered_alarms[index] = alarm;
+}
+
+static void
+alarm_registers_set (void)
+{
+    // Enable RTCC writes (for alarm enable bit)
+    rtcc_writes_enable();
+
+    // Disable alarm to change registers
+    rtcc_alarm_disable();
+
+    // Set Registers
+    ALRMHR  = registered_alarms[0].time.hour;
+    ALRMMIN = registered_alarms[0].time.minute;
+    if (0 == (registered_alarms[0].time.second & 0x0F))
+    {
+        ALRMSEC = registered_alarms[0].time.second + 1;
+    }
+    else
+    {
+        ALRMSEC = registered_alarms[0].time.second;
+    }
+
+    // Enable alarm
+    rtcc_alarm_enable();
+
+    // Disable writes
+    rtcc_writes_disable();
+}
+
+static void
+alarm_isr (void)
+{
+    // The time of day of the head has occurred. alarm is disabled.
+    datetime_t now;
+    unsigned long epoch;
+
+    // The RTCC only matches the time of day, so an alarm more than a day away
+    // matches before it is due. Only alarms that are due by now go off.
+    datetime_now(&now);
+    epoch = datetime_epoch(&now);
+
+    // Consume every alarm that is due by now and emit its event.
+    while (registered_alarms_count && (registered_alarms[0].epoch <= epoch))
+    {
+        event_isr((unsigned int)
+            EVENT_ID(ALARM_EVENT, registered_alarms[0].event_data)
+        );
+        alarm_remove(0);
+        alarm_store_dirty = 1;
+    }
+
+    // Check if we have any alarms registered
+    if (registered_alarms_count)
+    {
+        // Set alarm registers with head values. If the head wasn't due this
+        // arms it again for the same time on a later day.
+        alarm_registers_set();
     }
 
     // Clear alarm interrupt flag
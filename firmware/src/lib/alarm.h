@@ -8,23 +8,58 @@
  * and place the earliest requested alarm in the registers. Then on each
  * interrupt we set the alarm registers based on the next alarm to occur.
  * 
+ * The registered alarms are kept in a binary min-heap ordered by their seconds
+ * since 2000, so they sort correctly across days, months and years. The RTCC
+ * only matches the time of day, so on each interrupt the head is checked
+ * against the current date and time and only goes off once it is due.
+ * 
  * Each alarm interrupt will generate an event with the ALARM_EVENT type. The
  * event data will be the value given when the alarm was registered.
+ * 
+ * The registered alarms are kept in EEPROM as epoch seconds and event data,
+ * so they survive a reset. Changes are written by alarm_flush(), which the
+ * main loop calls before going to sleep, and only slots that changed are
+ * written. alarm_init() registers the stored alarms again. Alarms that went
+ * off while we were reset are sent as a single ALARM_EVENT_MISSED event, see
+ * alarm_missed(). After a power on reset the RTCC starts over from a default
+ * date, so every stored alarm counts as missed (see datetime_is_set()).
 */
 
 #ifndef _alarm_h_
 #define _alarm_h_
 
+////////////////////////////////////////
+// Lib Config //
+
 /**
  * Max alarms that can be registered at once.
  * 
  * A few alarms are going to always be registered:
  * - Hourly chime alarm? Might have its own ISR
  * - User configurable alarm
+ * - Daily battery reading and uptime counter
  * 
- * A couple extra should be enough.
+ * Registering and deleting an alarm takes O(log n), so this can go up to 255
+ * if there is RAM for it. Each alarm takes 8 bytes. The host tests raise it
+ * to see how the heap scales.
+*/
+#ifndef ALARM_MAX_ALARMS
+#define ALARM_MAX_ALARMS    16
+#endif
+
+/**
+ * EEPROM address of the stored alarms.
 */
-#define ALARM_MAX_ALARMS    10
+#define ALARM_STORE_ADDRESS 0x40
+
+/**
+ * Number of alarms kept in EEPROM. Each takes 5 bytes from
+ * ALARM_STORE_ADDRESS. If more alarms are registered, only the ones at the
+ * top of the heap are stored, which always includes the next alarm.
+*/
+#define ALARM_STORE_SLOTS   12
+
+////////////////////////////////////////
 
 // We use datetime objects for time and date values
 #include "lib/datetime.h"
@@ -58,6 +93,41 @@ alarm_set_datetime (datetime_t *alarm_datetime, unsigned char event_data);
 void
 alarm_get (datetime_t *alarm_datetime);
 
+/**
+ * Find a registered alarm by its event data.
+ * 
+ * @param[in]   event_data      Event data of the alarm.
+ * @param[out]  alarm_datetime  Set to the date and time of the first alarm
+ *                              with the event data. The weekday holds the
+ *                              event data.
+ * 
+ * @returns     1 if an alarm was found, 0 otherwise.
+*/
+unsigned char
+alarm_find_event (unsigned char event_data, datetime_t *alarm_datetime);
+
+/**
+ * Check if an alarm went off while we were reset.
+ * 
+ * Missed alarms are not registered again, and are only sent as one
+ * ALARM_EVENT_MISSED event. After a power on reset every stored alarm is
+ * missed, as the date is not known.
+ * 
+ * @param[in]   event_data      Event data of the alarm.
+ * @param[out]  alarm_datetime  Set to the date and time of the missed alarm.
+ * 
+ * @returns     1 if an alarm with the event data was missed, 0 otherwise.
+*/
+unsigned char
+alarm_missed (unsigned char event_data, datetime_t *alarm_datetime);
+
+/**
+ * Write changed alarms to EEPROM.
+ * This is called by the main loop when there is nothing else to do.
+*/
+void
+alarm_flush (void);
+
 /**
  * Delete all alarms with the given event data.
  * 
@@ -72,6 +142,9 @@ alarm_del_event (unsigned char event_data);
 
 #define ALARM_EVENT         0x0A
 
+// Event data of the event sent when alarms were missed during a reset.
+#define ALARM_EVENT_MISSED  0xFF
+
 #endif
 
 // EOF //
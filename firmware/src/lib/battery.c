@@ -14,6 +14,7 @@
 
 #include "drivers/adc.h"
 #include "drivers/fvr.h"
+#include "lib/eeprom.h"
 
 #include "lib/battery.h"
 
@@ -24,9 +25,54 @@
 #define FIXED_VOLTAGE_REP   1024UL    // Should we calculate this based on temp?
 #define MAX_VOLTAGE         4095UL    // Max ADC result.
 
+// History records store the voltage in centivolts, offset by 1.00V so a single
+// byte covers 1.00V - 3.54V. 0xFF is never written as a value or a sequence
+// number so an erased slot can be told apart from a record. A slot with an
+// erased sequence number but a value was being rewritten when we reset.
+#define HISTORY_OFFSET      100
+#define HISTORY_MAX_VALUE   0xFE
+#define HISTORY_ERASED      0xFF
+
+// Sequence numbers count 0 - 0xFE and wrap, skipping HISTORY_ERASED.
+#define HISTORY_SEQUENCES   0xFF
+
+/** Index of the slot the next history record will be written to. */
+static unsigned char history_head = 0;
+
+/** Number of valid records in the history ring. */
+static unsigned char history_count = 0;
+
+/** Sequence number of the next history record. */
+static unsigned char history_sequence = 0;
+
 // Configure ADC for battery use.
 static void battery_adc_config (void);
 
+// Find the head of the history ring.
+static void battery_history_init (void);
+
+// Read the sequence number stored in a history slot.
+#define history_slot_sequence(slot) \
+        eeprom_read(BATTERY_HISTORY_ADDRESS + ((slot) << 1))
+
+// Read the value stored in a history slot.
+#define history_slot_value(slot) \
+        eeprom_read(BATTERY_HISTORY_ADDRESS + ((slot) << 1) + 1)
+
+// Check if a history slot was never written.
+#define history_slot_erased(slot) \
+        ((HISTORY_ERASED == history_slot_sequence(slot)) \
+        && (HISTORY_ERASED == history_slot_value(slot)))
+
+// Check if a history slot was left half written by a reset.
+#define history_slot_torn(slot) \
+        ((HISTORY_ERASED == history_slot_sequence(slot)) \
+        && (HISTORY_ERASED != history_slot_value(slot)))
+
+// The sequence number that follows another.
+#define history_sequence_add(sequence, n) \
+        (unsigned char)(((unsigned int)(sequence) + (n)) % HISTORY_SEQUENCES)
+
 void
 battery_init (void)
 {
@@ -34,10 +80,19 @@ battery_init (void)
 
     // Initialize ADC driver.
     adc_init();
+
+    // Find where we left off in the history ring.
+    battery_history_init();
 }
 
 float
 battery_read_voltage (void)
+{
+    return ((float)battery_read_millivolts() / 1000);
+}
+
+unsigned int
+battery_read_millivolts (void)
 {
     unsigned int average = 0;
     unsigned int voltage = 0;
@@ -85,7 +140,158 @@ battery_read_voltage (void)
 
     LOG_DEBUG("Voltage: %u", voltage);
 
-    return ((float)voltage / 1000);
+    return voltage;
+}
+
+void
+battery_history_record (void)
+{
+    unsigned int centivolts = (battery_read_millivolts() + 5) / 10;
+    unsigned char value = 0;
+    unsigned char address = BATTERY_HISTORY_ADDRESS + (history_head << 1);
+
+    // Clamp the reading to what fits in a record.
+    //
+    if (HISTORY_OFFSET > centivolts)
+    {
+        value = 0;
+    }
+    else if ((HISTORY_OFFSET + HISTORY_MAX_VALUE) < centivolts)
+    {
+        value = HISTORY_MAX_VALUE;
+    }
+    else
+    {
+        value = (unsigned char)(centivolts - HISTORY_OFFSET);
+    }
+
+    // The sequence number is what makes the record part of the ring. It is
+    // erased before the value is replaced and written again last, so a reset
+    // in between leaves a torn slot that is skipped, instead of the new value
+    // under the old sequence number. Only the oldest record is lost. The queue
+    // keeps the writes in this order.
+    //
+    eeprom_write(address, HISTORY_ERASED);
+    eeprom_write(address + 1, value);
+    eeprom_write(address, history_sequence);
+
+    LOG_INFO("History: #%u %u.%.2uV", history_sequence,
+             (value + HISTORY_OFFSET) / 100, (value + HISTORY_OFFSET) % 100);
+
+    history_sequence = history_sequence_add(history_sequence, 1);
+    history_head = (history_head + 1) % BATTERY_HISTORY_RECORDS;
+
+    if (BATTERY_HISTORY_RECORDS > history_count)
+    {
+        history_count++;
+    }
+}
+
+unsigned char
+battery_history_count (void)
+{
+    return history_count;
+}
+
+unsigned int
+battery_history_get (unsigned char age)
+{
+    unsigned char slot = 0;
+
+    if (age >= history_count)
+    {
+        return 0;
+    }
+
+    slot = (history_head + (BATTERY_HISTORY_RECORDS - 1) - age) \
+            % BATTERY_HISTORY_RECORDS;
+
+    return (unsigned int)(history_slot_value(slot) + HISTORY_OFFSET) * 10;
+}
+
+static void
+battery_history_init (void)
+{
+    unsigned char base = 0;
+    unsigned char first = 0;
+    unsigned char low = 0;
+    unsigned char high = BATTERY_HISTORY_RECORDS - 1;
+    unsigned char mid = 0;
+
+    // A torn first slot means we reset while wrapping around to it, so the
+    // records start at the next slot.
+    //
+    if (history_slot_torn(0))
+    {
+        base = 1;
+    }
+    low = base;
+    first = history_slot_sequence(base);
+
+    // An erased first slot means nothing has been recorded yet.
+    //
+    if (history_slot_erased(base))
+    {
+        history_head = 0;
+        history_count = 0;
+        history_sequence = 0;
+        return;
+    }
+
+    // Records are written in slot order with incrementing sequence numbers,
+    // so starting from the first slot the sequence counts up until we reach
+    // the newest record. Every slot after that holds an older record, a torn
+    // record or nothing at all, and none of them continue the count. This
+    // lets us binary search for the newest record.
+    //
+    while (low < high)
+    {
+        mid = (unsigned char)((low + high + 1) >> 1);
+
+        if (history_sequence_add(first, mid - base) == history_slot_sequence(mid))
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    history_head = (low + 1) % BATTERY_HISTORY_RECORDS;
+    history_sequence = history_sequence_add(first, low - base + 1);
+
+    if (base)
+    {
+        // Every slot but the torn one holds a record.
+        history_count = BATTERY_HISTORY_RECORDS - 1;
+    }
+    else if ((0 != history_head) && history_slot_erased(history_head))
+    {
+        // The slot after the newest record is still erased, the ring has not
+        // wrapped yet.
+        history_count = history_head;
+    }
+    else if ((0 != history_head) && history_slot_torn(history_head))
+    {
+        // The newest record was being written past the oldest. If the slot
+        // after it is still erased, the ring has not wrapped yet either.
+        if (((history_head + 1) < BATTERY_HISTORY_RECORDS)
+            && history_slot_erased(history_head + 1))
+        {
+            history_count = history_head;
+        }
+        else
+        {
+            history_count = BATTERY_HISTORY_RECORDS - 1;
+        }
+    }
+    else
+    {
+        history_count = BATTERY_HISTORY_RECORDS;
+    }
+
+    LOG_INFO("History: %u records, head %u", history_count, history_head);
 }
 
 static void
@@ -5,14 +5,39 @@
  * The goal is to determine the current battery level. We do this currently by
  * just sampling the voltage with the built-in ADC.
  * 
+ * The library also keeps a history of battery readings in EEPROM so the
+ * discharge of the coin cell can be tracked over its lifetime. The history is
+ * an append-only ring of records. Each record holds a sequence number and the
+ * voltage in centivolts. Appending always writes the next slot in the ring, so
+ * the writes are spread evenly across the reserved EEPROM region instead of
+ * wearing out one fixed cell.
 */
 
 #ifndef _battery_h_
 #define _battery_h_
 
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * EEPROM address of the battery history ring.
+ * The ring occupies BATTERY_HISTORY_RECORDS * 2 bytes from this address.
+*/
+#define BATTERY_HISTORY_ADDRESS     0xC0
+
+/**
+ * Number of records kept in the battery history ring.
+ * This must be less than 128 for head discovery to work.
+*/
+#define BATTERY_HISTORY_RECORDS     32
+
+////////////////////////////////////////
+
 
 /**
  * Initialize the battery library.
+ * 
+ * This also finds the head of the battery history ring.
 */
 void
 battery_init (void);
@@ -25,6 +50,41 @@ battery_init (void);
 float
 battery_read_voltage (void);
 
+/**
+ * Gets an approximate value for the battery voltage in millivolts.
+ * 
+ * @returns     Battery voltage in mV.
+*/
+unsigned int
+battery_read_millivolts (void);
+
+/**
+ * Take a battery reading and append it to the history ring.
+ * 
+ * This is meant to be called once a day. When the ring is full the oldest
+ * record is overwritten.
+*/
+void
+battery_history_record (void);
+
+/**
+ * Get the amount of records stored in the battery history.
+ * 
+ * @returns     Number of records, 0 - BATTERY_HISTORY_RECORDS.
+*/
+unsigned char
+battery_history_count (void);
+
+/**
+ * Get a voltage from the battery history.
+ * 
+ * @param[in]   age     Age of the record to get. 0 is the newest record.
+ * 
+ * @returns     Recorded voltage in mV, or 0 if no record exists.
+*/
+unsigned int
+battery_history_get (unsigned char age);
+
 #endif
 
 // EOF //
@@ -11,6 +11,7 @@
 
 #include "lib/isr.h"
 #include "lib/events.h"
+#include "lib/input.h"
 
 #include "lib/buttons.h"
 
@@ -118,6 +119,7 @@ buttons_isr (void)
                 //
                 last_event_time = timer1_get();
                 event_isr(EVENT_ID(EVENT_BUTTON, BUTTON_MODE_RELEASE));
+                input_release(INPUT_BUTTONS, BUTTON_MODE_PRESS);
                 button_mode_pressed = 0;
             }
         }
@@ -130,6 +132,7 @@ buttons_isr (void)
                 //
                 last_event_time = timer1_get();
                 event_isr(EVENT_ID(EVENT_BUTTON, BUTTON_MODE_PRESS));
+                input_press(INPUT_BUTTONS, BUTTON_MODE_PRESS);
                 button_mode_pressed = 1;
             }
         }
@@ -146,6 +149,7 @@ buttons_isr (void)
             {
                 last_event_time = timer1_get();
                 event_isr(EVENT_ID(EVENT_BUTTON, BUTTON_ADJ_RELEASE));
+                input_release(INPUT_BUTTONS, BUTTON_ADJ_PRESS);
                 button_adj_pressed = 0;
             }
         }
@@ -155,6 +159,7 @@ buttons_isr (void)
             {
                 last_event_time = timer1_get();
                 event_isr(EVENT_ID(EVENT_BUTTON, BUTTON_ADJ_PRESS));
+                input_press(INPUT_BUTTONS, BUTTON_ADJ_PRESS);
                 button_adj_pressed = 1;
             }
         }
@@ -7,6 +7,8 @@
  * not passed on to the mode application. The MODE release event, however, is
  * passed to the mode application.
  * Both ADJ press and release events are sent to the mode.
+ * The button pressed last also generates long press, repeat and double press
+ * events, see lib/input.h.
  * 
  * TODO: Right now there is no debouncing implemented. Maybe we can use timer0.
 */
@@ -20,6 +22,15 @@
 #define BUTTON_ADJ_PRESS        0x02
 #define BUTTON_ADJ_RELEASE      0x12
 
+// Timed button events, see lib/input.h.
+#define BUTTON_MODE_LONG        0x31
+#define BUTTON_MODE_REPEAT      0x41
+#define BUTTON_MODE_DOUBLE      0x51
+
+#define BUTTON_ADJ_LONG         0x32
+#define BUTTON_ADJ_REPEAT       0x42
+#define BUTTON_ADJ_DOUBLE       0x52
+
 /**
  * Initializes the buttons.
  * Events are generated on each press and release.
@@ -3,13 +3,88 @@
  * This library implements functionality of the piezo buzzer on the watch.
  * 
  * It allows you to play a variable length tone with a given frequency and
- * volume. You can also play songs in the RTTTL ringtone format, although the
- * only one I've found that sounds good is the Super Mario Bros theme.
+ * volume.
+ * 
+ * A list of notes can be played in the background with buzzer_play(). The
+ * notes are timed with timeouts, so the mode keeps running and the CPU sleeps
+ * in between. It only idles instead of sleeping while a note is sounding. A
+ * BUZZER_EVENT_DONE event is sent when the last note is done. Its event data
+ * is the number buzzer_play() returned, so the caller can tell its own notes
+ * apart from notes that something else played in the meantime.
+ * Notes are built at compile time with BUZZER_NOTE(), so playing them needs
+ * no calculations. Songs in the RTTTL ringtone format can be built the same
+ * way, see lib/rtttl.h.
 */
 
 #ifndef _buzzer_h_
 #define _buzzer_h_
 
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * Compile the runtime RTTTL parser, buzzer_play_rtttl().
+ * Songs built with lib/rtttl.h don't need it.
+*/
+#define BUZZER_RTTTL_PARSER     0
+
+////////////////////////////////////////
+
+#include "drivers/pwm.h"
+#include "lib/timeout.h"
+
+// Buzzer events
+//
+#define BUZZER_EVENT_DONE       0x0D
+
+/**
+ * Convert milliseconds to buzzer note ticks.
+ * This is meant for constants, so the conversion is done at compile time.
+ * Notes and gaps are timed in timeout ticks, see TIMEOUT_HZ.
+*/
+#define BUZZER_MS(ms)           ((unsigned int)(((unsigned long)(ms) * TIMEOUT_HZ) / 1000))
+
+/**
+ * A note played by buzzer_play().
+ * Build these with BUZZER_NOTE() and BUZZER_REST().
+*/
+typedef struct
+{
+    unsigned char period;       /**< PWM timer period, 0 for a rest. */
+    unsigned char prescaler;    /**< PWM timer prescaler. */
+    unsigned char duty;         /**< PWM duty cycle register. */
+    unsigned int duration;      /**< Length of the note, see BUZZER_MS(). */
+    unsigned char gap;          /**< Silence after the note, see BUZZER_MS(). */
+} buzzer_note_t;
+
+/**
+ * A note with a frequency in hertz, a volume as a percentage, and a duration
+ * and following gap in milliseconds. The gap can be just short of a second.
+*/
+#define BUZZER_NOTE(freq, volume, ms, gap_ms)                               \
+    { PWM_PERIOD(freq), PWM_PRESCALER(freq), PWM_DUTY(freq, (volume) / 2),  \
+      BUZZER_MS(ms), (unsigned char)BUZZER_MS(gap_ms) }
+
+/**
+ * Silence for a duration in milliseconds.
+*/
+#define BUZZER_REST(ms)         { 0, 0, 0, BUZZER_MS(ms), 0 }
+
+// Frequencies of the notes in the 7th octave. Lower octaves are found by
+// halving them.
+#define NOTE_C7  2093
+#define NOTE_CS7 2217
+#define NOTE_D7  2349
+#define NOTE_DS7 2489
+#define NOTE_E7  2637
+#define NOTE_F7  2794
+#define NOTE_FS7 2960
+#define NOTE_G7  3136
+#define NOTE_GS7 3322
+#define NOTE_A7  3520
+#define NOTE_AS7 3729
+#define NOTE_B7  3951
+
 
 /**
  * Initialize the buzzer for use.
@@ -29,24 +104,43 @@ buzzer_tone (unsigned int frequency, unsigned char volume, unsigned int duration
 
 
 /**
- * Play a tone 2.
+ * Play a list of notes in the background.
+ * 
+ * This returns right away. Anything that is already playing is stopped.
+ * The notes are not copied, so they have to stay around until the
+ * BUZZER_EVENT_DONE event.
  * 
- * This function does not block like _tone, however time is only counted if the
- * cpu is awake. The cpu sleeps most of the time so tones can go on alot longer
- * than expected and are not always on. A fix for this would be to keep the pic
- * awake when we are playing a tone.
+ * @param[in]   notes       Notes to play.
+ * @param[in]   count       Number of notes.
  * 
- * We currently use the same timer to generate interrupts as we do to drive the
- * buzzer pwm. A side effect of this is we only count time when the buzzer is
- * actually sounding, a drawback is above.
+ * @returns     Number of this sequence, 1-255. The BUZZER_EVENT_DONE event
+ *              carries it as event data. 0 if there was nothing to play.
+*/
+unsigned char
+buzzer_play (const buzzer_note_t *notes, unsigned char count);
+
+/**
+ * Stop playing notes.
+ * No BUZZER_EVENT_DONE event is sent.
 */
 void
-buzzer_tone2 (unsigned int frequency, unsigned char volume, unsigned int duration);
+buzzer_stop (void);
+
+/**
+ * Check if notes are playing.
+ * 
+ * @returns     1 if buzzer_play() notes are playing, 0 otherwise.
+*/
+unsigned char
+buzzer_playing (void);
+
+#if BUZZER_RTTTL_PARSER
 
 /**
  * Play a song defined as an RTTTL string.
  * 
- * This will block for the entire song.
+ * This will block for the entire song. The parser is only compiled if
+ * BUZZER_RTTTL_PARSER is set, songs built with lib/rtttl.h play without it.
  * Currently this might not handle all of the various formats, but it seems to
  * handle most standard songs. The logic to determine the pitch frequency is
  * based on PlayRTTL: <https://github.com/ArminJo/PlayRtttl>.
@@ -56,6 +150,7 @@ buzzer_tone2 (unsigned int frequency, unsigned char volume, unsigned int duratio
 void
 buzzer_play_rtttl(char * rtttl_str);
 
+#endif
 
 #endif
 
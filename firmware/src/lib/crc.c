@@ -0,0 +1,32 @@
+/** @file crc.c
+ * 
+ * CRC lib for CasiOS.
+*/
+
+#include "lib/crc.h"
+
+/** CRC-8 polynomial, x^8 + x^2 + x + 1. */
+#define CRC8_POLYNOMIAL 0x07
+
+unsigned char
+crc8 (unsigned char crc, unsigned char data)
+{
+    crc ^= data;
+
+    // One bit at a time, a table would take 256 bytes of flash.
+    for (unsigned char bit = 0; bit < 8; bit++)
+    {
+        if (crc & 0x80)
+        {
+            crc = (unsigned char)((crc << 1) ^ CRC8_POLYNOMIAL);
+        }
+        else
+        {
+            crc = (unsigned char)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+// EOF //
@@ -0,0 +1,30 @@
+/** @file crc.h
+ * 
+ * CRC lib for CasiOS.
+ * 
+ * An 8-bit CRC (polynomial 0x07) used to check data stored in EEPROM.
+*/
+
+#ifndef _crc_h_
+#define _crc_h_
+
+/**
+ * Starting value of a CRC.
+ * Not 0, so data that was zeroed doesn't pass with a CRC of 0.
+*/
+#define CRC8_INIT       0xFF
+
+/**
+ * Add a byte to a CRC.
+ * 
+ * @param[in]   crc     CRC of the data so far, CRC8_INIT to start.
+ * @param[in]   data    Next byte of data.
+ * 
+ * @returns     CRC including the byte.
+*/
+unsigned char
+crc8 (unsigned char crc, unsigned char data);
+
+#endif
+
+// EOF //
@@ -22,12 +22,40 @@ const char weekday_str[7][3] = {
     "SA"
 };
 
+// Days in each month of a common year.
+static const unsigned char month_days[12] = {
+    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+// Seconds in a day.
+#define DAY_SECONDS     86400UL
+
+// Days in a cycle of 4 years, starting with a leap year.
+#define CYCLE_DAYS      1461
+
+// 2000-01-01 was a saturday.
+#define EPOCH_WEEKDAY   6
+
+// Cleared when the RTCC starts over after losing power, until the date and
+// time are set again.
+static unsigned char datetime_known = 1;
+
 
 void
 datetime_init (void)
 {
     LOG_INFO("Initializing rtcc...");
 
+    // The RTCC keeps running through any reset but a power on reset, so we
+    // only set the time if we lost power.
+    if (PCON0bits.nPOR)
+    {
+        rtcc_init();
+        return;
+    }
+    PCON0bits.nPOR = 1;
+    datetime_known = 0;
+
 #   ifdef DTINIT_SEC
     // The DTINIT_* macros allow us to set an initial date and time at compile time
     rtcc_time_set(DTINIT_HOUR, DTINIT_MIN, DTINIT_SEC);
@@ -62,6 +90,14 @@ datetime_set (datetime_t *dt)
 
     rtcc_time_set(dt->time.hour, dt->time.minute, dt->time.second);
     rtcc_date_set(dt->date.year, dt->date.month, dt->date.day, dt->date.weekday);
+
+    datetime_known = 1;
+}
+
+unsigned char
+datetime_is_set (void)
+{
+    return datetime_known;
 }
 
 void
@@ -143,6 +179,85 @@ datetime_today (date_t *d)
 #   endif
 }
 
+
+// Epoch functions
+
+unsigned long
+datetime_epoch (datetime_t *dt)
+{
+    unsigned char year = BCD2DEC(dt->date.year);
+    unsigned char month = BCD2DEC(dt->date.month);
+    unsigned int days;
+
+    // Every year before this one, with a leap day every 4 years starting
+    // with 2000.
+    days = (unsigned int)(year * 365U + ((year + 3) >> 2));
+
+    for (unsigned char m = 1; m < month; m++)
+    {
+        days += month_days[m - 1];
+    }
+
+    if ((month > 2) && !(year & 0x03))
+    {
+        days++;
+    }
+
+    days += BCD2DEC(dt->date.day) - 1;
+
+    return (days * DAY_SECONDS)
+        + (BCD2DEC(dt->time.hour) * 3600UL)
+        + (unsigned int)(BCD2DEC(dt->time.minute) * 60U)
+        + BCD2DEC(dt->time.second);
+}
+
+void
+datetime_from_epoch (unsigned long epoch, datetime_t *dt)
+{
+    unsigned int days = (unsigned int)(epoch / DAY_SECONDS);
+    unsigned long seconds = epoch % DAY_SECONDS;
+    unsigned char year;
+    unsigned char month;
+    unsigned char length;
+
+    dt->time.hour = (unsigned char)DEC2BCD(seconds / 3600);
+    seconds %= 3600;
+    dt->time.minute = (unsigned char)DEC2BCD(seconds / 60);
+    dt->time.second = (unsigned char)DEC2BCD(seconds % 60);
+
+    dt->date.weekday = (unsigned char)((days + EPOCH_WEEKDAY) % 7);
+
+    // Whole cycles of 4 years, then the leap year that starts the cycle, then
+    // the common years after it.
+    year = (unsigned char)((days / CYCLE_DAYS) << 2);
+    days %= CYCLE_DAYS;
+    if (days >= 366)
+    {
+        days -= 366;
+        year += 1 + (unsigned char)(days / 365);
+        days %= 365;
+    }
+
+    for (month = 0; month < 11; month++)
+    {
+        length = month_days[month];
+        if ((1 == month) && !(year & 0x03))
+        {
+            length++;
+        }
+
+        if (days < length)
+        {
+            break;
+        }
+        days -= length;
+    }
+
+    dt->date.year = (unsigned char)DEC2BCD(year);
+    dt->date.month = (unsigned char)DEC2BCD(month + 1);
+    dt->date.day = (unsigned char)DEC2BCD(days + 1);
+}
+
 const char *
 datetime_weekday_str (unsigned char weekday)
 {
@@ -40,6 +40,18 @@ void datetime_init (void);
 void
 datetime_set (datetime_t *datetime);
 
+/**
+ * Check if the date and time are known.
+ * 
+ * After a power on reset the RTCC starts over from a default date and time,
+ * which stays wrong until datetime_set() is called.
+ * 
+ * @returns     0 after a power on reset until the date and time are set,
+ *              1 otherwise.
+*/
+unsigned char
+datetime_is_set (void);
+
 /**
  * Gets the current date and time.
  * 
@@ -101,6 +113,30 @@ datetime_today (date_t *date);
 */
 #define DEC2BCD(val)    ((((val) / 10) << 4) | ((val) % 10))
 
+/**
+ * Convert a date and time to seconds since 2000-01-01 00:00:00.
+ * 
+ * Epoch seconds compare in the right order across days, months and years,
+ * which makes them easier to sort and store than the BCD fields. The weekday
+ * is ignored.
+ * 
+ * @param[in]   datetime    A pointer to a datetime object.
+ * 
+ * @returns     Seconds since 2000.
+*/
+unsigned long
+datetime_epoch (datetime_t *datetime);
+
+/**
+ * Convert seconds since 2000-01-01 00:00:00 to a date and time.
+ * 
+ * @param[in]   epoch       Seconds since 2000.
+ * @param[out]  datetime    A pointer to a datetime object that will hold the
+ *                          date and time, including the weekday.
+*/
+void
+datetime_from_epoch (unsigned long epoch, datetime_t *datetime);
+
 /**
  * Get a short string representation of a weekday value.
  * 
@@ -24,6 +24,29 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * Maximum number of characters of text that can be scrolled.
+ * Longer text is cut off.
+*/
+#define DISPLAY_SCROLL_LENGTH           64
+
+/**
+ * Seconds without input before the LCD switches to its idle power profile.
+ * 0 keeps the LCD in the active profile.
+*/
+#define DISPLAY_IDLE_SECONDS            10
+
+/**
+ * Minutes without input before the LCD is turned off.
+ * 0 keeps the LCD on.
+*/
+#define DISPLAY_OFF_MINUTES             0
+
+////////////////////////////////////////
+
 #define DISPLAY_PERIOD_COLON            9
 
 #define DISPLAY_MISC_BELL               1
@@ -37,6 +60,31 @@
 #define DISPLAY_SIGN_MULTIPLY           3
 #define DISPLAY_SIGN_DIVIDE             4
 
+#define DISPLAY_SCROLL_ONCE             0
+#define DISPLAY_SCROLL_LOOP             1
+
+// Fonts are selected with FONTS in the Makefile. Fall back to the default
+// font if none were selected.
+#if !defined(FONT_DEFAULT) && !defined(FONT_NUMERIC) && !defined(FONT_WIDE)
+#   define FONT_DEFAULT
+#endif
+
+/**
+ * Fonts that are compiled into the firmware.
+ * The first one is used until display_set_font() is called.
+*/
+enum display_font_id {
+#ifdef FONT_DEFAULT
+    DISPLAY_FONT_DEFAULT,       // Letters, numbers, and punctuation
+#endif
+#ifdef FONT_NUMERIC
+    DISPLAY_FONT_NUMERIC,       // Numbers only
+#endif
+#ifdef FONT_WIDE
+    DISPLAY_FONT_WIDE,          // Default with 10-segment secondary letters
+#endif
+    DISPLAY_FONT_COUNT
+};
 
 
 void    display_init (void);
@@ -49,14 +97,18 @@ void    display_primary_character       (signed char position, unsigned char cha
 void    display_primary_string          (signed char position, const char *string);
 void    display_primary_number          (signed char position, long number);
 void    display_primary_hex             (signed char position, unsigned long number);
+void    display_primary_bcd             (signed char position, unsigned long bcd, unsigned char digits);
 void    display_primary_clear           (signed char position);
+void    display_primary_blink           (signed char position, unsigned char period);
 
 void    display_secondary_segments      (signed char position, unsigned int segments);
 void    display_secondary_character     (signed char position, unsigned char character);
 void    display_secondary_string        (signed char position, const char *string);
 void    display_secondary_number        (signed char position, int number);
 void    display_secondary_hex           (signed char position, unsigned char number);
+void    display_secondary_bcd           (signed char position, unsigned char bcd, unsigned char digits);
 void    display_secondary_clear         (signed char position);
+void    display_secondary_blink         (signed char position, unsigned char period);
 
 void    display_period                  (signed char position);
 void    display_period_clear            (signed char position);
@@ -66,6 +118,25 @@ void    display_sign_clear              (signed char position);
 
 void    display_misc                    (signed char position);
 void    display_misc_clear              (signed char position);
+void    display_misc_blink              (signed char position, unsigned char period);
+
+// Blinking positions toggle every period timeout ticks (see TIMEOUT_MS() in
+// lib/timeout.h). A period of 0 stops a position from blinking. Everything
+// blinks at the rate last given.
+void    display_blink_clear             (void);
+
+// Scrolling text enters the primary display from the right and moves one
+// character every period timeout ticks. DISPLAY_SCROLL_ONCE stops when the end
+// of the text is shown, DISPLAY_SCROLL_LOOP scrolls it off and starts over.
+void    display_primary_scroll          (const char *string, unsigned char period, unsigned char mode);
+void    display_scroll_stop             (void);
+unsigned char display_scroll_active     (void);
+
+// Input keeps the LCD in its active power profile. After DISPLAY_IDLE_SECONDS
+// without a call to display_wake() it switches to the idle profile, and after
+// DISPLAY_OFF_MINUTES it turns off. Drawing while off is shown on wake.
+// Returns 1 if the display was off.
+unsigned char display_wake              (void);
 
 
 void display_segments_zero (void);
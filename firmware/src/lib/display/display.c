@@ -9,6 +9,7 @@
 
 #include "drivers/lcd.h"
 
+#include "lib/isr.h"
 #include "lib/display.h"
 #include "lib/display/display_priv.h"
 #include "lib/display/fonts.h"
@@ -17,16 +18,31 @@
 #include "lib/logging.h"
 
 
-volatile unsigned char display_needs_update = 0;
+const display_font_t * volatile display_font;
 
-const unsigned char * volatile display_font;
+volatile unsigned char display_primary_buffer[LCD_PRIMARY_CHARACTERS + 1];
+
+volatile unsigned char display_secondary_buffer[LCD_SECONDARY_CHARACTERS + 1];
+
+const unsigned char display_hex_digits[16] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 'A', 'b', 'C', 'd', 'E', 'F'
+};
 
 #ifdef DISPLAY_DEBUG
 
-volatile unsigned char debug_display[8];
+// Ascii representation of a primary framebuffer position.
+#define debug_display(position)                                         \
+    ((DISPLAY_BUFFER_SEGMENTS == display_primary_buffer[position]) ?    \
+        '?' : display_primary_buffer[position] + DISPLAY_CHARACTER_ASCII_OFFSET)
 
 #endif
 
+// Reset the framebuffers to match a blank LCD.
+static void display_buffers_clear (void);
+
+/** Commits the working buffer to the LCD at the start of a frame. */
+static void display_isr (void);
+
 /**
  * Initialize the display.
  * This initializes the LCD driver and configures the default state.
@@ -36,48 +52,106 @@ display_init (void)
 {
     lcd_init();
 
-    display_needs_update = 0;
+    // Register frame interrupt used for display updates.
+    isr_register(8, _PIR8_LCDIF_MASK, &display_isr);
 
     // Configure our default font.
-    display_font = default_font;
+    display_font = &display_fonts[0];
 
-#   ifdef DISPLAY_DEBUG
+    // The LCD starts blank.
+    display_buffers_clear();
 
-    // Initialize the debug display to blank spaces
-    for (char i = 0; i < 9; i++)
-    {
-        debug_display[i] = ' ';
-    }
-
-#   endif
+    // Start counting down to the idle power profile.
+    display_wake();
 }
 
 /**
  * Update the display if needed.
- * If the lcd segment buffers have been edited this calls to update the lcd.
+ * If the lcd segment buffers have changed this schedules an update of the lcd
+ * at the start of the next frame. Redrawing identical content does not count
+ * as a change, and calling this several times before the next frame results
+ * in a single update. The caller does not wait for the update; it is done in
+ * the frame interrupt, which also wakes us from sleep.
+ * Scrolling text is also moved along here when it is due.
 */
 void
 display_update (void)
 {
-    if (display_needs_update)
-    {
-        lcd_update();
+    display_scroll_update();
 
+    if (lcd_is_dirty())
+    {
 #       ifdef DISPLAY_DEBUG
         
         LOG_INFO("%c%c%c%c%c%c%c%c",
-            debug_display[0],
-            debug_display[1],
-            debug_display[2],
-            debug_display[3],
-            debug_display[4],
-            debug_display[5],
-            debug_display[6],
-            debug_display[7]);
+            debug_display(1),
+            debug_display(2),
+            debug_display(3),
+            debug_display(4),
+            debug_display(5),
+            debug_display(6),
+            debug_display(7),
+            debug_display(8));
         
 #       endif
 
-        display_needs_update = 0;
+        lcd_update_ready();
+
+        lcd_frame_interrupt_clear();
+        lcd_frame_interrupt_enable();
+    }
+}
+
+void
+display_set_font (unsigned char font)
+{
+    if (DISPLAY_FONT_COUNT <= font)
+    {
+        LOG_ERROR("Font not compiled in: %i", font);
+        return;
+    }
+
+    display_font = &display_fonts[font];
+
+    // The framebuffers hold font indices, so everything shown can be drawn
+    // again in the new font.
+    display_primary_redraw();
+    display_secondary_redraw();
+}
+
+unsigned char
+display_font_primary (unsigned char character)
+{
+    character -= display_font->first;
+
+    if (character >= display_font->count)
+    {
+        return 0;
+    }
+
+    return display_font->primary[character];
+}
+
+unsigned int
+display_font_secondary (unsigned char character)
+{
+    if ((unsigned char)(character - display_font->first) < display_font->secondary_count)
+    {
+        return display_font->secondary[character - display_font->first];
+    }
+
+    return display_font_primary(character);
+}
+
+static void
+display_isr (void)
+{
+    lcd_frame_interrupt_clear();
+
+    // Write the buffer if the LCD allows it, otherwise try again next frame.
+    if (lcd_update_frame())
+    {
+        lcd_frame_interrupt_disable();
     }
 }
 
@@ -112,10 +186,80 @@ character_normalize (unsigned char character)
     return character;
 }
 
+unsigned long
+display_bcd_encode (unsigned long binary)
+{
+    // BCD result, least significant byte first.
+    unsigned char bcd[4] = {0, 0, 0, 0};
+    unsigned char bits = 32;
+
+    // Leading zeros never add anything to the result, so skip them.
+    while (bits && !(binary & 0x80000000UL))
+    {
+        binary <<= 1;
+        bits--;
+    }
+
+    while (bits--)
+    {
+        unsigned char carry;
+        unsigned char next;
+
+        // Add 3 to every digit that is 5 or more, so it carries into the next
+        // digit when shifted.
+        for (unsigned char i = 0; i < 4; i++)
+        {
+            if ((bcd[i] & 0x0F) >= 0x05)
+            {
+                bcd[i] += 0x03;
+            }
+            if ((bcd[i] & 0xF0) >= 0x50)
+            {
+                bcd[i] += 0x30;
+            }
+        }
+
+        // Shift the next bit of the binary number into the BCD digits.
+        carry = (binary & 0x80000000UL) ? 1 : 0;
+        binary <<= 1;
+
+        for (unsigned char i = 0; i < 4; i++)
+        {
+            next = bcd[i] >> 7;
+            bcd[i] = (unsigned char)(bcd[i] << 1) | carry;
+            carry = next;
+        }
+    }
+
+    return ((unsigned long)bcd[3] << 24)
+         | ((unsigned long)bcd[2] << 16)
+         | ((unsigned int)bcd[1] << 8)
+         | bcd[0];
+}
+
 void
 display_segments_zero (void)
 {
     lcd_segments_clear();
+    display_buffers_clear();
+}
+
+static void
+display_buffers_clear (void)
+{
+    unsigned char position = 0;
+
+    // A space is font index 0.
+    //
+    for (position = 0; position <= LCD_PRIMARY_CHARACTERS; position++)
+    {
+        display_primary_buffer[position] = character_normalize(' ');
+    }
+
+    for (position = 0; position <= LCD_SECONDARY_CHARACTERS; position++)
+    {
+        display_secondary_buffer[position] = character_normalize(' ');
+    }
 }
 
 // EOF //
@@ -0,0 +1,143 @@
+/** @file display_blink.c
+ *
+ * Display library for CasiOS
+ *
+ * Functions related to blinking parts of the display.
+ *
+ * Everything that blinks shares one rate and phase. The blinking is done by
+ * the LCD driver, toggled from a timeout and written to the LCD in the frame
+ * interrupt, so the mode application is not woken up for it.
+*/
+
+#include "drivers/lcd.h"
+#include "lib/timeout.h"
+#include "lib/display.h"
+#include "lib/display/display_priv.h"
+
+
+/** Timeout ticks between blink toggles. 0 when nothing is blinking. */
+static volatile unsigned char display_blink_period = 0;
+
+/** Toggle the blinking segments. Called from the timeout interrupt. */
+static void display_blink_toggle (void);
+
+/**
+ * Start or stop the blink timeout depending on whether anything is blinking.
+*/
+static void display_blink_schedule (unsigned char period);
+
+
+ //////////////////////////////////////////////////////////////////////////////
+// Blinking
+
+void
+display_primary_blink (signed char position, unsigned char period)
+{
+    if (position)
+    {
+        position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
+        lcd_primary_blink((unsigned char)position, (period) ? 1 : 0);
+    }
+    else
+    {
+        // If position is zero we blink all characters
+        for (position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+        {
+            lcd_primary_blink((unsigned char)position, (period) ? 1 : 0);
+        }
+    }
+
+    display_blink_schedule(period);
+}
+
+void
+display_secondary_blink (signed char position, unsigned char period)
+{
+    if (position)
+    {
+        position = position_normalize(position, LCD_SECONDARY_CHARACTERS);
+        lcd_secondary_blink((unsigned char)position, (period) ? 1 : 0);
+    }
+    else
+    {
+        // If position is zero we blink all characters
+        for (position = 1; position <= LCD_SECONDARY_CHARACTERS; position++)
+        {
+            lcd_secondary_blink((unsigned char)position, (period) ? 1 : 0);
+        }
+    }
+
+    display_blink_schedule(period);
+}
+
+void
+display_misc_blink (signed char position, unsigned char period)
+{
+    if (0 > position)
+    {
+        position += LCD_MISC_SEGMENTS + 1;
+    }
+
+    if (0 < position)
+    {
+        lcd_misc_blink((unsigned char)position, (period) ? 1 : 0);
+    }
+    else
+    {
+        // 0 - blink all misc segments
+        for (position = 1; position <= LCD_MISC_SEGMENTS; position++)
+        {
+            lcd_misc_blink((unsigned char)position, (period) ? 1 : 0);
+        }
+    }
+
+    display_blink_schedule(period);
+}
+
+void
+display_blink_clear (void)
+{
+    timeout_cancel(&display_blink_toggle);
+    display_blink_period = 0;
+
+    lcd_blink_clear();
+}
+
+
+static void
+display_blink_schedule (unsigned char period)
+{
+    if (!lcd_blink_active())
+    {
+        // Nothing left to blink.
+        display_blink_clear();
+    }
+    else if (period)
+    {
+        if (!display_blink_period)
+        {
+            // Start blinking. The first toggle hides the segments.
+            timeout_set(&display_blink_toggle, period);
+        }
+
+        // A new period is picked up by the next toggle.
+        display_blink_period = period;
+    }
+}
+
+static void
+display_blink_toggle (void)
+{
+    lcd_blink_toggle();
+
+    // Show the new phase at the start of the next frame.
+    lcd_frame_interrupt_clear();
+    lcd_frame_interrupt_enable();
+
+    if (display_blink_period)
+    {
+        timeout_set(&display_blink_toggle, display_blink_period);
+    }
+}
+
+// EOF //
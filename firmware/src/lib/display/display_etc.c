@@ -33,7 +33,6 @@ display_period (signed char position)
             lcd_period_draw((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 void
@@ -56,7 +55,6 @@ display_period_clear (signed char position)
             lcd_period_clear((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 
@@ -82,7 +80,6 @@ void    display_sign                    (signed char position)
             lcd_sign_draw((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 void    display_sign_clear              (signed char position)
@@ -104,7 +101,6 @@ void    display_sign_clear              (signed char position)
             lcd_sign_clear((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 
@@ -130,7 +126,6 @@ void    display_misc                    (signed char position)
             lcd_misc_draw((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 void    display_misc_clear              (signed char position)
@@ -152,7 +147,6 @@ void    display_misc_clear              (signed char position)
             lcd_misc_clear((unsigned char)position);
         }
     }
-    display_needs_update = 1;
 }
 
 // EOF //
@@ -0,0 +1,115 @@
+/** @file display_power.c
+ *
+ * Display library for CasiOS
+ *
+ * Functions related to the power used by the display.
+ *
+ * The LCD runs in its active power profile while it is being used. Once there
+ * has been no input for DISPLAY_IDLE_SECONDS it switches to the idle profile,
+ * which drives the LCD slower and with less voltage. If DISPLAY_OFF_MINUTES
+ * is set, the LCD is turned off completely after that long without input.
+ * The seconds are counted with a timeout that stops once there is nothing
+ * left to count down to.
+*/
+
+#include "drivers/lcd.h"
+#include "lib/timeout.h"
+#include "lib/display.h"
+#include "lib/display/display_priv.h"
+
+
+/**
+ * Timeout ticks in a step of the countdown.
+ * The longest timeout is just short of a second, so this is about a second.
+*/
+#define DISPLAY_POWER_STEP      TIMEOUT_MS(980)
+
+/** Seconds without input until the LCD is turned off. */
+#define DISPLAY_OFF_SECONDS     ((unsigned int)DISPLAY_OFF_MINUTES * 60)
+
+// States of the display power.
+#define DISPLAY_POWER_ACTIVE    0
+#define DISPLAY_POWER_IDLE      1
+#define DISPLAY_POWER_OFF       2
+
+/** Current state of the display power. */
+static volatile unsigned char display_power_state = DISPLAY_POWER_ACTIVE;
+
+/** Seconds since the last input. */
+static volatile unsigned int display_power_seconds = 0;
+
+/** Count the seconds without input. Called from the timeout interrupt. */
+static void display_power_timeout (void);
+
+
+ //////////////////////////////////////////////////////////////////////////////
+// Power
+
+unsigned char
+display_wake (void)
+{
+    unsigned char was_off = 0;
+
+#   if DISPLAY_IDLE_SECONDS || DISPLAY_OFF_MINUTES
+    // Keep the timeout out while the state changes.
+    timeout_cancel(&display_power_timeout);
+
+    if (DISPLAY_POWER_OFF == display_power_state)
+    {
+        // Everything drawn while off is shown in one go.
+        lcd_enable();
+        was_off = 1;
+    }
+
+    if (DISPLAY_POWER_ACTIVE != display_power_state)
+    {
+        lcd_power_profile(LCD_POWER_ACTIVE);
+        lcd_frame_interrupt_clear();
+        lcd_frame_interrupt_enable();
+    }
+
+    display_power_state = DISPLAY_POWER_ACTIVE;
+    display_power_seconds = 0;
+    timeout_set(&display_power_timeout, DISPLAY_POWER_STEP);
+#   endif
+
+    return was_off;
+}
+
+
+static void
+display_power_timeout (void)
+{
+    display_power_seconds++;
+
+#   if DISPLAY_IDLE_SECONDS
+    if (DISPLAY_IDLE_SECONDS == display_power_seconds)
+    {
+        // Nobody is looking, switch at the start of the next frame.
+        lcd_power_profile(LCD_POWER_IDLE);
+        lcd_frame_interrupt_clear();
+        lcd_frame_interrupt_enable();
+        display_power_state = DISPLAY_POWER_IDLE;
+    }
+#   endif
+
+#   if DISPLAY_OFF_MINUTES
+    if (DISPLAY_OFF_SECONDS <= display_power_seconds)
+    {
+        lcd_disable();
+        display_power_state = DISPLAY_POWER_OFF;
+
+        // Nothing left to count down to.
+        return;
+    }
+#   else
+    if (DISPLAY_IDLE_SECONDS <= display_power_seconds)
+    {
+        return;
+    }
+#   endif
+
+    timeout_set(&display_power_timeout, DISPLAY_POWER_STEP);
+}
+
+// EOF //
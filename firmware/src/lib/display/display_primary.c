@@ -7,59 +7,46 @@
 
 #include "drivers/lcd.h"
 #include "lib/display.h"
-#include "lib/display/fonts.h"
 #include "lib/display/display_priv.h"
 
 
  //////////////////////////////////////////////////////////////////////////////
 // Primary
 
+/**
+ * Draw a font character to a normalized position, if the framebuffer shows
+ * that it is not already there.
+*/
+static void display_primary_draw (unsigned char position, unsigned char character);
+
 void
 display_primary_segments (signed char position, unsigned char segments)
 {
     position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
 
-    for (char bit = 0; bit < LCD_PRIMARY_CHARACTER_SEGMENTS; bit++)
-    {
-        if ((1U << bit) & segments)
-        {
-            lcd_primary_draw((unsigned char)position, bit);
-        }
-        else
-        {
-            lcd_primary_clear((unsigned char)position, bit);
-        }
-    }
+    // Raw segments are not a character, so the framebuffer can't be used to
+    // skip the next draw at this position.
+    display_primary_buffer[position] = DISPLAY_BUFFER_SEGMENTS;
 
-    display_needs_update = 1;
+    lcd_primary_glyph((unsigned char)position, segments);
 }
 
 void
 display_primary_character (signed char position, unsigned char character)
 {
-    // Position will get normalized in the call to display_primary_segments
-    // position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
-
     character = character_normalize(character);
 
-    unsigned char segments = display_font[character];
-
     if (position)
     {
-        display_primary_segments(position, segments);
-#       ifdef DISPLAY_DEBUG
-        debug_display[position-1] = character+DISPLAY_CHARACTER_ASCII_OFFSET;
-#       endif
+        position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
+        display_primary_draw((unsigned char)position, character);
     }
     else
     {
         // If position is zero we set all characters
         for (position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
         {
-            display_primary_segments(position, segments);
-#           ifdef DISPLAY_DEBUG
-            debug_display[position-1] = character+DISPLAY_CHARACTER_ASCII_OFFSET;
-#           endif
+            display_primary_draw((unsigned char)position, character);
         }
     }
 }
@@ -184,20 +171,19 @@ display_primary_number (signed char position, long number)
         }
 
         // Draw the absolute value of the number to the display.
-        unsigned char number_char = 0;
-        while (0 < number && 0 < position)
-        {
-            number_char = number % 10;
-
-            display_primary_character(position--, number_char);
-
-            number /= 10;
-        }
+        unsigned long bcd = display_bcd_encode((unsigned long)number);
+        display_primary_bcd(position, bcd, 0);
 
         // Draw our '-' sign if necessary.
         if (negative_number)
         {
-            // We should always have a postion leftover for the negative sign.
+            // Skip over the digits we just drew. We should always have a
+            // postion leftover for the negative sign.
+            while (bcd)
+            {
+                position--;
+                bcd >>= 4;
+            }
             display_primary_character(position, '-');
         }
     }
@@ -213,87 +199,66 @@ display_primary_number (signed char position, long number)
 void
 display_primary_hex (signed char position, unsigned long number)
 {
-    if (0 == number)
-    {
-        // Special case for 0
-        display_primary_character(position, 0);
-    }
-    else
-    {
-        position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
+    // Hex digits are drawn one nibble at a time, exactly like BCD digits.
+    display_primary_bcd(position, number, 0);
+}
 
-        // Draw each digit as an ascii character.
-        unsigned char number_char = 0;
-        while (0 < number && 0 < position)
-        {
-            number_char = number % 16;
 
-            if (number_char > 9)
-            {
-                switch (number_char)
-                {
-                    case 10:
-                        number_char = 'A';
-                    break;
-                    case 11:
-                        number_char = 'b';
-                    break;
-                    case 12:
-                        number_char = 'C';
-                    break;
-                    case 13:
-                        number_char = 'd';
-                    break;
-                    case 14:
-                        number_char = 'E';
-                    break;
-                    case 15:
-                        number_char = 'F';
-                    break;
-
-                    default:
-                    break;
-                }
-            }
+/**
+ * Display a packed BCD number.
+ * 
+ * Each nibble of bcd is drawn as one digit, with the least significant nibble
+ * at position. This draws the BCD values of datetime_t directly, without
+ * converting them to binary first.
+ * 
+ * @param[in]   position    Position of least significant digit.
+ * @param[in]   bcd         Packed BCD number to display.
+ * @param[in]   digits      Number of digits to draw, including leading zeros.
+ *                          0 draws only the significant digits.
+*/
+void
+display_primary_bcd (signed char position, unsigned long bcd, unsigned char digits)
+{
+    position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
 
-            display_primary_character(position--, number_char);
+    // Always draw at least the ones digit.
+    do
+    {
+        display_primary_character(position--, display_hex_digits[bcd & 0x0F]);
+        bcd >>= 4;
 
-            number /= 16;
+        if (digits)
+        {
+            digits--;
         }
-    }
+    } while ((bcd || digits) && 0 < position);
 }
 
 void
 display_primary_clear (signed char position)
 {
-    // char seg = 0;
-
-    // position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
+    // Clearing is drawing a space. 0 clears whole primary display.
+    display_primary_character(position, ' ');
+}
 
-    // Clear character
-    if (position)
+static void
+display_primary_draw (unsigned char position, unsigned char character)
+{
+    if (display_primary_buffer[position] != character)
     {
-        display_primary_segments(position, 0);
-
-#       ifdef DISPLAY_DEBUG
-
-        debug_display[position-1] = ' ';
-
-#       endif
+        display_primary_buffer[position] = character;
+        lcd_primary_glyph(position, display_font_primary(character));
     }
+}
 
-    // 0 clears whole primary display.
-    else
+void
+display_primary_redraw (void)
+{
+    for (unsigned char position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
     {
-        for (position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+        if (DISPLAY_BUFFER_SEGMENTS != display_primary_buffer[position])
         {
-            display_primary_segments(position, 0);
-
-#           ifdef DISPLAY_DEBUG
-
-            debug_display[position-1] = ' ';
-
-#           endif
+            lcd_primary_glyph(position, display_font_primary(display_primary_buffer[position]));
         }
     }
 }
@@ -7,20 +7,45 @@
 #ifndef _display_priv_h_
 #define _display_priv_h_
 
-/** Flag to determine if the display has changed. */
-extern volatile unsigned char display_needs_update;
+#include "drivers/lcd.h"
+
+#include "lib/display/fonts.h"
 
 /** Currently configured font to use for displaying characters.*/
-extern const unsigned char * volatile display_font;
+extern const display_font_t * volatile display_font;
+
+/**
+ * Framebuffer value of a position that was drawn with raw segments instead of
+ * a font character.
+*/
+#define DISPLAY_BUFFER_SEGMENTS     0xFF
+
+/**
+ * Primary display framebuffer.
+ * This holds the font index of the character currently shown at each position
+ * of the primary display, starting with position 1. Characters are only sent
+ * to the LCD driver if they differ from what the framebuffer holds.
+*/
+extern volatile unsigned char display_primary_buffer[LCD_PRIMARY_CHARACTERS + 1];
+
+/**
+ * Secondary display framebuffer.
+ * This holds the font index of the character currently shown at each position
+ * of the secondary display, starting with position 1.
+*/
+extern volatile unsigned char display_secondary_buffer[LCD_SECONDARY_CHARACTERS + 1];
+
+/**
+ * Font characters of the 16 hexadecimal digits.
+ * Packed BCD digits are a subset of these, so both are drawn from this table.
+*/
+extern const unsigned char display_hex_digits[16];
 
 #if LOG_LVL >= LOG_LVL_INFO
 
 // The debug display is enabled for every log level
 #define DISPLAY_DEBUG
 
-/** The debug display holds the content of the primary display as ascii characters. */
-extern volatile unsigned char debug_display[8];
-
 #endif
 
 /**
@@ -49,6 +74,61 @@ position_normalize (signed char position, unsigned char display_len);
 unsigned char
 character_normalize (unsigned char character);
 
+/**
+ * Look up the 7-segment representation of a font character.
+ *
+ * @param[in]   character       Font index of the character.
+ *
+ * @returns     Segments of the character in the current font. Characters the
+ *              font does not have are blank.
+*/
+unsigned char
+display_font_primary (unsigned char character);
+
+/**
+ * Look up the 10-segment representation of a font character.
+ *
+ * @param[in]   character       Font index of the character.
+ *
+ * @returns     Segments of the character in the current font.
+*/
+unsigned int
+display_font_secondary (unsigned char character);
+
+/**
+ * Redraw every character of the primary display from the framebuffer.
+ * Positions drawn with raw segments are left alone.
+*/
+void
+display_primary_redraw (void);
+
+/**
+ * Redraw every character of the secondary display from the framebuffer.
+ * Positions drawn with raw segments are left alone.
+*/
+void
+display_secondary_redraw (void);
+
+/**
+ * Convert a binary number to packed BCD.
+ * This uses the shift-and-add-3 (double dabble) algorithm, so no division is
+ * needed. The result holds 8 digits, so the number must be below 100,000,000.
+ * 
+ * @param[in]   binary          Number to convert.
+ * 
+ * @returns     The packed BCD representation of binary.
+*/
+unsigned long
+display_bcd_encode (unsigned long binary);
+
+/**
+ * Draw the next step of scrolling text if one is due.
+ * This is called by display_update(), so the step is drawn from the main
+ * loop and not from the timeout interrupt.
+*/
+void
+display_scroll_update (void);
+
 #endif
 
 // EOF //
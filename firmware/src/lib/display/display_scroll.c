@@ -0,0 +1,164 @@
+/** @file display_scroll.c
+ *
+ * Display library for CasiOS
+ *
+ * Functions related to scrolling text across the primary display.
+ *
+ * The text is encoded through the font once when scrolling starts. Every step
+ * shifts the window of shown segments one character to the left and feeds in
+ * the next encoded character on the right. Only the positions whose segments
+ * changed are drawn. Steps are timed by a timeout and drawn the next time
+ * display_update() is called, so nothing blocks while the text scrolls.
+*/
+
+#include "drivers/lcd.h"
+#include "lib/timeout.h"
+#include "lib/display.h"
+#include "lib/display/display_priv.h"
+
+
+/** Segments of the text being scrolled. */
+static unsigned char display_scroll_segments[DISPLAY_SCROLL_LENGTH];
+
+/** Number of characters in the text being scrolled. */
+static unsigned char display_scroll_length = 0;
+
+/** Index of the next character to feed into the window. */
+static unsigned char display_scroll_next = 0;
+
+/** Segments currently shown on each position of the primary display. */
+static unsigned char display_scroll_window[LCD_PRIMARY_CHARACTERS];
+
+/** Timeout ticks between steps. 0 when not scrolling. */
+static volatile unsigned char display_scroll_period = 0;
+
+/** Scroll mode, DISPLAY_SCROLL_ONCE or DISPLAY_SCROLL_LOOP. */
+static unsigned char display_scroll_mode = DISPLAY_SCROLL_ONCE;
+
+/** Set by the timeout when the next step is due. */
+static volatile unsigned char display_scroll_due = 0;
+
+/** Flag the next step as due. Called from the timeout interrupt. */
+static void display_scroll_timeout (void);
+
+/** Move the text one character to the left. */
+static void display_scroll_step (void);
+
+
+ //////////////////////////////////////////////////////////////////////////////
+// Scrolling
+
+void
+display_primary_scroll (const char *string, unsigned char period, unsigned char mode)
+{
+    display_scroll_stop();
+
+    // Encode the text once.
+    display_scroll_length = 0;
+    while (*string && display_scroll_length < DISPLAY_SCROLL_LENGTH)
+    {
+        display_scroll_segments[display_scroll_length++] =
+            display_font_primary(character_normalize((unsigned char)*string++));
+    }
+
+    // Start with a blank window, the text comes in from the right. This is
+    // the only time every position is drawn, steps only draw what changed.
+    for (unsigned char position = 0; position < LCD_PRIMARY_CHARACTERS; position++)
+    {
+        display_scroll_window[position] = display_font_primary(character_normalize(' '));
+        display_primary_segments((signed char)(position + 1), display_scroll_window[position]);
+    }
+
+    display_scroll_next = 0;
+    display_scroll_mode = mode;
+    display_scroll_period = (period) ? period : 1;
+
+    // The first character is shown right away.
+    display_scroll_step();
+}
+
+void
+display_scroll_stop (void)
+{
+    timeout_cancel(&display_scroll_timeout);
+    display_scroll_period = 0;
+    display_scroll_due = 0;
+}
+
+unsigned char
+display_scroll_active (void)
+{
+    return (display_scroll_period) ? 1 : 0;
+}
+
+void
+display_scroll_update (void)
+{
+    if (display_scroll_due)
+    {
+        display_scroll_due = 0;
+        display_scroll_step();
+    }
+}
+
+
+static void
+display_scroll_step (void)
+{
+    unsigned char position;
+    unsigned char segments;
+
+    // Shift the window left by one character. Only positions that change are
+    // drawn, runs of the same character (like the blank gap) stay put.
+    for (position = 0; position < LCD_PRIMARY_CHARACTERS; position++)
+    {
+        if (position < LCD_PRIMARY_CHARACTERS - 1)
+        {
+            segments = display_scroll_window[position + 1];
+        }
+        else if (display_scroll_next < display_scroll_length)
+        {
+            // Feed in the next character,
+            segments = display_scroll_segments[display_scroll_next];
+        }
+        else
+        {
+            // or a blank in the gap between loops.
+            segments = display_font_primary(character_normalize(' '));
+        }
+
+        if (display_scroll_window[position] != segments)
+        {
+            display_scroll_window[position] = segments;
+            display_primary_segments((signed char)(position + 1), segments);
+        }
+    }
+    display_scroll_next++;
+
+    if (DISPLAY_SCROLL_LOOP == display_scroll_mode)
+    {
+        // Start over once the text has scrolled off the display.
+        if (display_scroll_next >= display_scroll_length + LCD_PRIMARY_CHARACTERS)
+        {
+            display_scroll_next = 0;
+        }
+    }
+    else if (display_scroll_next >= display_scroll_length)
+    {
+        // The end of the text is shown, we're done.
+        display_scroll_stop();
+        return;
+    }
+
+    timeout_set(&display_scroll_timeout, display_scroll_period);
+}
+
+static void
+display_scroll_timeout (void)
+{
+    // The step itself is drawn from the main loop, so the ISR never touches
+    // the LCD buffer while a mode is drawing to it.
+    display_scroll_due = 1;
+}
+
+// EOF //
@@ -13,45 +13,65 @@
  //////////////////////////////////////////////////////////////////////////////
 // Secondary
 
+/**
+ * Draw a font character to a normalized position, if the framebuffer shows
+ * that it is not already there.
+*/
+static void display_secondary_draw (unsigned char position, unsigned char character);
+
+// Draw raw segments to a normalized position.
+static void display_secondary_glyph (unsigned char position, unsigned int segments);
+
+// Segments of a character that the position has. Position 1 has all 3 extra
+// segments that 10-segment characters use, position 2 only the first.
+#define display_secondary_segments_of(position, character)                 \
+    (display_font_secondary(character) & lcd_secondary_mask(position))
+
 void
 display_secondary_segments (signed char position, unsigned int segments)
 {
     position = position_normalize(position, LCD_SECONDARY_CHARACTERS);
 
+    // Raw segments are not a character, so the framebuffer can't be used to
+    // skip the next draw at this position.
+    display_secondary_buffer[position] = DISPLAY_BUFFER_SEGMENTS;
+
+    display_secondary_glyph((unsigned char)position, segments);
+}
+
+static void
+display_secondary_glyph (unsigned char position, unsigned int segments)
+{
     // Draw 10 secondary segments
     for (char bit = 0; bit < LCD_SECONDARY_CHARACTER_SEGMENTS; bit++)
     {
         if ((1U << bit) & segments)
         {
-            lcd_secondary_draw((unsigned char)position, bit);
+            lcd_secondary_draw(position, bit);
         }
         else
         {
-            lcd_secondary_clear((unsigned char)position, bit);
+            lcd_secondary_clear(position, bit);
         }
     }
-
-    display_needs_update = 1;
 }
 
 void
 display_secondary_character (signed char position, unsigned char character)
 {
     character = character_normalize(character);
-    unsigned char segments = display_font[character];
 
     if (position)
     {
-        // We currently don't use the extra segments for displaying characters
-        // so we cast our (char) character segments as ints.
-        display_secondary_segments(position, (unsigned int)segments);
+        position = position_normalize(position, LCD_SECONDARY_CHARACTERS);
+        display_secondary_draw((unsigned char)position, character);
     }
     else
     {
         // If position is zero we set all characters
         for (position = 1; position <= LCD_SECONDARY_CHARACTERS; position++)
         {
-            display_secondary_segments(position, (unsigned int)segments);
+            display_secondary_draw((unsigned char)position, character);
         }
     }
 }
@@ -108,6 +128,15 @@ display_secondary_string (signed char position, const char *string)
     }
 }
 
+// Draw the extra '1' of the secondary display for numbers 100-199. The
+// framebuffer does not know about the extra segment, so we make sure the next
+// character drawn to position 1 redraws all of its segments.
+#define display_secondary_hundred()                                 \
+    do {                                                            \
+        lcd_secondary_draw(1, 9);                                   \
+        display_secondary_buffer[1] = DISPLAY_BUFFER_SEGMENTS;      \
+    } while (0)
+
 void
 display_secondary_number (signed char position, int number)
 {
@@ -117,26 +146,16 @@ display_secondary_number (signed char position, int number)
     {
         if (200 > number)
         {
-            if (100 == number)
-            {
-                display_secondary_character(2, 0);
-                display_secondary_character(1, 0);
-                lcd_secondary_draw(1, 9);
-            }
-            else if (100 < number)
+            if (100 <= number)
             {
+                // Hundreds always show both digits, e.g. "1 05".
                 number -= 100;
-                display_secondary_character(2, (unsigned char)(number % 10));
-                display_secondary_character(1, (unsigned char)(number / 10));
-                lcd_secondary_draw(1, 9);
+                display_secondary_bcd(2, (unsigned char)display_bcd_encode((unsigned long)number), 2);
+                display_secondary_hundred();
             }
             else
             {
-                display_secondary_character(2, number % 10);
-                if (9 < number)
-                {
-                    display_secondary_character(1, (unsigned char)(number / 10));
-                }
+                display_secondary_bcd(2, (unsigned char)display_bcd_encode((unsigned long)number), 0);
             }
         }
         else
@@ -175,72 +194,64 @@ display_secondary_number (signed char position, int number)
 void
 display_secondary_hex (signed char position, unsigned char number)
 {
-    if (0 == number)
-    {
-        // Special case for 0
-        display_secondary_character(position, 0);
-    }
-    else
-    {
-        position = position_normalize(position, LCD_SECONDARY_CHARACTERS);
+    // Hex digits are drawn one nibble at a time, exactly like BCD digits.
+    display_secondary_bcd(position, number, 0);
+}
 
-        // Draw each digit as an ascii character.
-        unsigned char number_char = 0;
-        while (0 < number && 0 < position)
-        {
-            number_char = number % 16;
 
-            if (number_char > 9)
-            {
-                switch (number_char)
-                {
-                    case 10:
-                        number_char = 'A';
-                    break;
-                    case 11:
-                        number_char = 'b';
-                    break;
-                    case 12:
-                        number_char = 'C';
-                    break;
-                    case 13:
-                        number_char = 'd';
-                    break;
-                    case 14:
-                        number_char = 'E';
-                    break;
-                    case 15:
-                        number_char = 'F';
-                    break;
-
-                    default:
-                    break;
-                }
-            }
+/**
+ * Display a packed BCD number.
+ * 
+ * @param[in]   position    Position of least significant digit.
+ * @param[in]   bcd         Packed BCD number to display.
+ * @param[in]   digits      Number of digits to draw, including leading zeros.
+ *                          0 draws only the significant digits.
+*/
+void
+display_secondary_bcd (signed char position, unsigned char bcd, unsigned char digits)
+{
+    position = position_normalize(position, LCD_SECONDARY_CHARACTERS);
 
-            display_secondary_character(position--, number_char);
+    // Always draw at least the ones digit.
+    do
+    {
+        display_secondary_character(position--, display_hex_digits[bcd & 0x0F]);
+        bcd >>= 4;
 
-            number /= 16;
+        if (digits)
+        {
+            digits--;
         }
-    }
+    } while ((bcd || digits) && 0 < position);
 }
 
 
 void
 display_secondary_clear (signed char position)
 {
-    // If the position is not zero, clear only that position.
-    if (position)
+    // Clearing is drawing a space. 0 clears the entire display.
+    display_secondary_character(position, ' ');
+}
+
+static void
+display_secondary_draw (unsigned char position, unsigned char character)
+{
+    if (display_secondary_buffer[position] != character)
     {
-        display_secondary_segments(position, 0);
+        display_secondary_buffer[position] = character;
+        display_secondary_glyph(position, display_secondary_segments_of(position, character));
     }
+}
 
-    // If the position is 0, clear the entire display
-    else
+void
+display_secondary_redraw (void)
+{
+    for (unsigned char position = 1; position <= LCD_SECONDARY_CHARACTERS; position++)
     {
-        for (position = 1; position < 3; position++)
+        if (DISPLAY_BUFFER_SEGMENTS != display_secondary_buffer[position])
         {
-            display_secondary_segments(position, 0);
+            display_secondary_glyph(position,
+                display_secondary_segments_of(position, display_secondary_buffer[position]));
         }
     }
 }
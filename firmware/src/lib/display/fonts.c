@@ -0,0 +1,281 @@
+/** @file fonts.c
+ *
+ * Fonts for the display library.
+ *
+ * Each font is only compiled if it is listed in FONTS in the Makefile, so
+ * builds that don't use a font don't pay for it.
+*/
+
+#include "lib/display.h"
+#include "lib/display/fonts.h"
+
+
+#if defined(FONT_DEFAULT) || defined(FONT_WIDE)
+
+/**
+ * Default display font.
+ *
+ * The default font maps ascii characters to the closest representation possible.
+ * Both capital and lowercase letters are implemented. Some cases cannot be made
+ * on a 7-segment display so the opposite case is used instead. For example, 'D'
+ * cannot be represented without looking like a '0', so lowercase 'd' is used
+ * instead. Special cases like these are marked with a '**' in the code.
+*/
+static const unsigned char default_font[FONT_SIZE] = {
+
+    // Punctuation
+    0x0,                // Space
+    B|C|P,              // !
+    B|F,                // "
+    0x0,                // # ???
+    0x0,                // $ ???
+    0x0,                // % ???
+    0x0,                // & ???
+    F,                  // ' Top left
+    B|C,                // ( Line on right side
+    E|F,                // ) Line on left side
+    A|B|F|G,            // * Like a degrees sign
+    D|E,                // + Kinda like a shorter L
+    E,                  // , Bottom left
+    G,                  // -
+    P,                  // . This adds a period but takes up a space.
+    B|E|G,              // /
+
+    // Numbers 0-9
+    A|B|C|D|E|F,        // 0
+    B|C,                // 1
+    A|B|D|E|G,          // 2
+    A|B|C|D|G,          // 3
+    B|C|F|G,            // 4
+    A|C|D|F|G,          // 5
+    A|C|D|E|F|G,        // 6
+    A|B|C|F,            // 7
+    A|B|C|D|E|F|G,      // 8
+    A|B|C|D|F|G,        // 9
+
+    // Punctuation
+    0x0,                // : ???
+    0x0,                // ; ???
+    D|E|G,              // < Like c
+    D|G,                // =
+    C|D|G,              // > Like a backwards c
+    A|B|E|G,            // ? No dot - kinda weird
+    0x0,                // @ ???
+    
+    // Uppercase alphabet
+    A|B|C|E|F|G,        // A
+    F|E|G|C|D,          // B ** Lowercase
+    A|D|E|F,            // C
+    B|C|D|E|G,          // D ** Lowercase
+    A|D|E|F|G,          // E
+    A|E|F|G,            // F
+    A|C|D|E|F|G,        // G
+    B|C|E|F|G,          // H
+    E|F,                // I Like 1 except on the left
+    B|C|D|E,            // J
+    B|C|E|F|G,          // K Like H and X
+    D|E|F,              // L
+    A|C|E,              // M Kinda weird
+    A|B|C|E|F,          // N ** Big lowercase n
+    A|B|C|D|E|F,        // O
+    A|B|E|F|G,          // P
+    A|B|C|D|E|F,        // Q Like O
+    A|E|F,              // R ** Lowercase, but big
+    A|C|D|F|G,          // S Like a 5
+    A|E|F,              // T Upside down L
+    B|C|D|E|F,          // U Like V
+    B|C|D|E|F,          // V Like U
+    B|D|F,              // W Kinda weird
+    B|C|E|F|G,          // X Like H and K
+    B|C|F|G,            // Y
+    A|B|D|E|G,          // Z
+
+    // Punctuation
+    A|D|E|F,            // [ Like C
+    C|F|G,              // \ backslash
+    A|B|C|D,            // ] Like a backwards C
+    A|B|F,              // ^
+    D,                  // _
+    B,                  // ` Top right
+    
+    // Lowercase alphabet
+    A|B|C|E|F|G,        // A ** Uppercase
+    F|E|G|C|D,          // b
+    D|E|G,              // c
+    B|C|D|E|G,          // d
+    A|D|E|F|G,          // E ** Uppercase
+    A|E|F|G,            // f
+    A|B|C|D|F|G,        // g
+    C|E|F|G,            // h
+    E,                  // i No dot, on left
+    B|C|D|E,            // J
+    B|C|E|F|G,          // K ** Uppercase Like H and X
+    D|E|F,              // l Like a capitol I
+    A|C|E,              // M Kinda weird
+    C|E|G,              // n
+    C|D|E|G,            // o
+    A|B|E|F|G,          // P ** Uppercase
+    A|B|C|F|G,          // q Backwards P
+    E|G,                // R ** Lowercase
+    A|C|D|F|G,          // S Like a 5
+    D|E|F|G,            // t
+    C|D|E,              // u Like v
+    C|D|E,              // v Like u
+    B|D|F,              // W Kinda weird
+    B|C|E|F|G,          // X ** Uppercase Like H and K
+    B|C|D|F|G,          // Y
+    A|B|D|E|G,          // Z ** Uppercase pretty much
+
+    // Punctuation
+    B|C|G,              // {
+    B|C,                // | Left side
+    E|F|G,              // }
+    A,                  // ~ Top segment
+};
+
+#endif
+
+#ifdef FONT_NUMERIC
+
+/**
+ * Numeric display font.
+ *
+ * This only covers space through '9', which is enough for numbers and the
+ * punctuation drawn around them. The 6, 7 and 9 are drawn without their tails
+ * like on a calculator.
+*/
+static const unsigned char numeric_font['9' - DISPLAY_CHARACTER_ASCII_OFFSET + 1] = {
+
+    // Punctuation
+    0x0,                // Space
+    B|C|P,              // !
+    B|F,                // "
+    0x0,                // #
+    0x0,                // $
+    0x0,                // %
+    0x0,                // &
+    F,                  // '
+    B|C,                // (
+    E|F,                // )
+    A|B|F|G,            // * Like a degrees sign
+    D|E,                // +
+    E,                  // ,
+    G,                  // -
+    P,                  // .
+    B|E|G,              // /
+
+    // Numbers 0-9
+    A|B|C|D|E|F,        // 0
+    B|C,                // 1
+    A|B|D|E|G,          // 2
+    A|B|C|D|G,          // 3
+    B|C|F|G,            // 4
+    A|C|D|F|G,          // 5
+    C|D|E|F|G,          // 6 No tail
+    A|B|C,              // 7 No tail
+    A|B|C|D|E|F|G,      // 8
+    A|B|C|F|G,          // 9 No tail
+};
+
+#endif
+
+#ifdef FONT_WIDE
+
+/**
+ * 10-segment secondary characters of the wide font.
+ *
+ * This covers space through 'Z'. Letters that can't be made from 7 segments
+ * use the extra segments of the half character left of position 1, so the
+ * weekdays can be spelled out with plain strings. The rest of the font is the
+ * default font.
+*/
+static const unsigned int wide_font['Z' - DISPLAY_CHARACTER_ASCII_OFFSET + 1] = {
+
+    // Punctuation
+    0x0,                // Space
+    B|C,                // ! No dot, P is an extra segment here
+    B|F,                // "
+    0x0,                // #
+    0x0,                // $
+    0x0,                // %
+    0x0,                // &
+    F,                  // '
+    B|C,                // (
+    E|F,                // )
+    A|B|F|G,            // *
+    D|E,                // +
+    E,                  // ,
+    G,                  // -
+    0x0,                // . There is no period on the secondary display
+    B|E|G,              // /
+
+    // Numbers 0-9
+    A|B|C|D|E|F,        // 0
+    B|C,                // 1
+    A|B|D|E|G,          // 2
+    A|B|C|D|G,          // 3
+    B|C|F|G,            // 4
+    A|C|D|F|G,          // 5
+    A|C|D|E|F|G,        // 6
+    A|B|C|F,            // 7
+    A|B|C|D|E|F|G,      // 8
+    A|B|C|D|F|G,        // 9
+
+    // Punctuation
+    0x0,                // :
+    0x0,                // ;
+    D|E|G,              // <
+    D|G,                // =
+    C|D|G,              // >
+    A|B|E|G,            // ?
+    0x0,                // @
+
+    // Uppercase alphabet
+    A|B|C|E|F|G,        // A
+    F|E|G|C|D,          // B ** Lowercase
+    A|D|E|F,            // C
+    B|C|D|E|G,          // D ** Lowercase
+    A|D|E|F|G,          // E
+    A|E|F|G,            // F
+    A|C|D|E|F|G,        // G
+    B|C|E|F|G,          // H
+    E|F,                // I
+    B|C|D|E,            // J
+    B|C|E|F|G,          // K
+    D|E|F,              // L
+    A|B|C|E|F|P|I,      // M Uses the extra segments
+    A|B|C|E|F,          // N
+    A|B|C|D|E|F,        // O
+    A|B|E|F|G,          // P
+    A|B|C|D|E|F,        // Q
+    A|E|F,              // R
+    A|C|D|F|G,          // S
+    A|E|F|P,            // T Uses the extra segments
+    B|C|D|E|F,          // U
+    B|C|D|E|F,          // V
+    B|C|D|E|F|H|I,      // W Uses the extra segments
+    B|C|E|F|G,          // X
+    B|C|F|G,            // Y
+    A|B|D|E|G,          // Z
+};
+
+#endif
+
+
+/**
+ * Available display fonts.
+ * These must be in the same order as the DISPLAY_FONT_* ids in display.h.
+*/
+const display_font_t display_fonts[] = {
+#ifdef FONT_DEFAULT
+    { default_font, 0, 0, FONT_SIZE, 0 },
+#endif
+#ifdef FONT_NUMERIC
+    { numeric_font, 0, 0, sizeof(numeric_font), 0 },
+#endif
+#ifdef FONT_WIDE
+    { default_font, wide_font, 0, FONT_SIZE, sizeof(wide_font) / sizeof(wide_font[0]) },
+#endif
+};
+
+// EOF //
@@ -0,0 +1,140 @@
+/** @file eeprom.c
+ * 
+ * EEPROM write queue for CasiOS.
+*/
+
+#include <xc.h>
+
+#include "drivers/nvm.h"
+
+#include "lib/isr.h"
+#include "lib/events.h"
+
+#include "lib/eeprom.h"
+
+
+/** A byte waiting to be written. */
+typedef struct
+{
+    unsigned char address;
+    unsigned char data;
+} eeprom_write_t;
+
+/** Ring buffer of writes. The write at the head is the one in progress. */
+static volatile eeprom_write_t eeprom_queue[EEPROM_QUEUE_LENGTH];
+
+/** Index of the write in progress. */
+static volatile unsigned char eeprom_queue_head = 0;
+
+/** Number of writes in the queue, including the one in progress. */
+static volatile unsigned char eeprom_queue_count = 0;
+
+/** Start the next write when the last one is done. */
+static void eeprom_isr (void);
+
+
+void
+eeprom_init (void)
+{
+    eeprom_queue_head = 0;
+    eeprom_queue_count = 0;
+
+    isr_register(7, _PIR7_NVMIF_MASK, &eeprom_isr);
+
+    nvm_interrupt_clear();
+    nvm_interrupt_enable();
+}
+
+unsigned char
+eeprom_read (unsigned char address)
+{
+    unsigned char data;
+    unsigned char slot;
+
+    // Hold the queue while we use the NVM registers. A finished write waits
+    // with its flag set until we're done.
+    nvm_interrupt_disable();
+
+    // The newest queued write of the address is what it will end up as.
+    for (unsigned char i = eeprom_queue_count; i; i--)
+    {
+        slot = (eeprom_queue_head + i - 1) % EEPROM_QUEUE_LENGTH;
+        if (eeprom_queue[slot].address == address)
+        {
+            data = eeprom_queue[slot].data;
+            nvm_interrupt_enable();
+            return data;
+        }
+    }
+
+    while (nvm_busy())
+    {
+        // Wait for the write in progress.
+    }
+
+    data = nvm_eeprom_read(address);
+
+    nvm_interrupt_enable();
+
+    return data;
+}
+
+void
+eeprom_write (unsigned char address, unsigned char data)
+{
+    while (EEPROM_QUEUE_LENGTH == eeprom_queue_count)
+    {
+        // Queue is full, wait for the interrupt to make room.
+    }
+
+    unsigned char slot;
+
+    nvm_interrupt_disable();
+
+    slot = (eeprom_queue_head + eeprom_queue_count) % EEPROM_QUEUE_LENGTH;
+    eeprom_queue[slot].address = address;
+    eeprom_queue[slot].data = data;
+
+    if (0 == eeprom_queue_count++)
+    {
+        // Nothing is being written, start right away.
+        nvm_eeprom_write_start(address, data);
+    }
+
+    nvm_interrupt_enable();
+}
+
+unsigned char
+eeprom_busy (void)
+{
+    return (eeprom_queue_count) ? 1 : 0;
+}
+
+
+static void
+eeprom_isr (void)
+{
+    nvm_interrupt_clear();
+
+    if (!eeprom_queue_count)
+    {
+        // Not one of ours.
+        return;
+    }
+
+    // The write at the head is done.
+    eeprom_queue_head = (eeprom_queue_head + 1) % EEPROM_QUEUE_LENGTH;
+
+    if (--eeprom_queue_count)
+    {
+        nvm_eeprom_write_start(eeprom_queue[eeprom_queue_head].address,
+            eeprom_queue[eeprom_queue_head].data);
+    }
+    else
+    {
+        nvm_eeprom_write_end();
+        event_isr(EVENT_ID(EEPROM_EVENT_DONE, 0));
+    }
+}
+
+// EOF //
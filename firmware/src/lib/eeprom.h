@@ -0,0 +1,71 @@
+/** @file eeprom.h
+ * 
+ * EEPROM write queue for CasiOS.
+ * 
+ * Each byte written to EEPROM takes a few milliseconds. Instead of waiting for
+ * every byte, writes are added to a queue and written one after another from
+ * the NVM interrupt, so the CPU can sleep in the meantime. Once the queue is
+ * empty an EEPROM_EVENT_DONE event is sent, so everything queued together
+ * makes up one batch.
+ * 
+ * Writes are done in the order they were queued. Reads pause the queue for a
+ * moment, and return data that is still waiting in the queue.
+*/
+
+#ifndef _eeprom_h_
+#define _eeprom_h_
+
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * Number of bytes that can wait to be written at the same time.
+ * Queueing more than this waits for room in the queue.
+*/
+#define EEPROM_QUEUE_LENGTH     16
+
+////////////////////////////////////////
+
+
+// EEPROM events
+//
+#define EEPROM_EVENT_DONE       0x0E
+
+/**
+ * Initialize the EEPROM write queue.
+*/
+void
+eeprom_init (void);
+
+/**
+ * Read a byte of EEPROM.
+ * 
+ * @param[in]   address EEPROM address to read.
+ * 
+ * @returns     Byte of data, including queued writes.
+*/
+unsigned char
+eeprom_read (unsigned char address);
+
+/**
+ * Queue a byte to be written to EEPROM.
+ * 
+ * This returns right away, unless the queue is full.
+ * 
+ * @param[in]   address EEPROM address to write.
+ * @param[in]   data    Byte of data to write.
+*/
+void
+eeprom_write (unsigned char address, unsigned char data);
+
+/**
+ * Check if writes are still waiting to be done.
+ * 
+ * @returns     1 while writing, 0 when everything is written.
+*/
+unsigned char
+eeprom_busy (void);
+
+#endif
+
+// EOF //
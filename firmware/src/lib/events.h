@@ -92,6 +92,10 @@ event_check (void);
 
 #define EVENT_KEYPAD        0x0C    // 'C' for ceypad :)
 
+#define EVENT_BUZZER        0x0D    // 'D' for done
+
+#define EVENT_EEPROM        0x0E    // 'E' for EEPROM
+
 #endif
 
 // EOF //
@@ -0,0 +1,139 @@
+/** @file input.c
+ * Input library for CasiOS.
+*/
+
+#include <xc.h>
+
+#include "lib/events.h"
+#include "lib/timeout.h"
+
+#include "lib/input.h"
+
+
+/** Timeout ticks in a step. */
+#define INPUT_STEP              TIMEOUT_MS(INPUT_STEP_MS)
+
+#define INPUT_LONG_PRESS        INPUT_STEPS(INPUT_LONG_PRESS_MS)
+#define INPUT_DOUBLE_PRESS      INPUT_STEPS(INPUT_DOUBLE_PRESS_MS)
+
+/** Timing of the last key pressed on an input. */
+typedef struct
+{
+    unsigned char key;          /**< Event data of the key. */
+    unsigned char held;         /**< 1 while the key is down. */
+    unsigned char armed;        /**< 1 while a double press is possible. */
+    unsigned char steps;        /**< Steps since the key was pressed or released. */
+} input_t;
+
+static volatile input_t inputs[2];
+
+/** Steps between repeat events. 0 when not repeating. */
+static volatile unsigned char input_repeat = 0;
+
+/** Count steps and send timed events. Called from the timeout interrupt. */
+static void input_timeout (void);
+
+/** Send a gesture event for a key of an input. */
+static void input_event (unsigned char input, unsigned char gesture, unsigned char key);
+
+
+void
+input_repeat_set (unsigned char steps)
+{
+    input_repeat = steps;
+}
+
+void
+input_press (unsigned char input, unsigned char key)
+{
+    if (inputs[input].armed && (key == inputs[input].key))
+    {
+        input_event(input, INPUT_GESTURE_DOUBLE, key);
+    }
+
+    inputs[input].key = key;
+    inputs[input].held = 1;
+    inputs[input].armed = 0;
+    inputs[input].steps = 0;
+
+    timeout_set(&input_timeout, INPUT_STEP);
+}
+
+void
+input_release (unsigned char input, unsigned char key)
+{
+    // Only the key pressed last is timed.
+    if (inputs[input].held && (key == inputs[input].key))
+    {
+        inputs[input].held = 0;
+        inputs[input].armed = 1;
+        inputs[input].steps = 0;
+    }
+}
+
+
+static void
+input_timeout (void)
+{
+    unsigned char running = 0;
+
+    for (unsigned char input = 0; input < 2; input++)
+    {
+        if (inputs[input].held)
+        {
+            inputs[input].steps++;
+
+            if (INPUT_LONG_PRESS == inputs[input].steps)
+            {
+                input_event(input, INPUT_GESTURE_LONG, inputs[input].key);
+            }
+            else if (INPUT_LONG_PRESS < inputs[input].steps)
+            {
+                if (!input_repeat)
+                {
+                    // Nothing left to time until the next press.
+                    inputs[input].held = 0;
+                }
+                else if (INPUT_LONG_PRESS + input_repeat <= inputs[input].steps)
+                {
+                    input_event(input, INPUT_GESTURE_REPEAT, inputs[input].key);
+
+                    // Count the next repeat from the long press again, so the
+                    // steps never overflow.
+                    inputs[input].steps = INPUT_LONG_PRESS;
+                }
+            }
+
+            running |= inputs[input].held;
+        }
+        else if (inputs[input].armed)
+        {
+            if (INPUT_DOUBLE_PRESS <= ++inputs[input].steps)
+            {
+                inputs[input].armed = 0;
+            }
+
+            running |= inputs[input].armed;
+        }
+    }
+
+    if (running)
+    {
+        timeout_set(&input_timeout, INPUT_STEP);
+    }
+}
+
+static void
+input_event (unsigned char input, unsigned char gesture, unsigned char key)
+{
+    if (INPUT_KEYPAD == input)
+    {
+        event_isr((unsigned int)EVENT_ID(gesture | EVENT_KEYPAD, key));
+    }
+    else
+    {
+        event_isr((unsigned int)EVENT_ID(EVENT_BUTTON, gesture | key));
+    }
+}
+
+// EOF //
@@ -0,0 +1,92 @@
+/** @file input.h
+ * Input library for CasiOS.
+ *
+ * Times how keys and buttons are pressed, so modes can react to held and
+ * double pressed keys without a fast tickrate:
+ * - LONG       The key was held for INPUT_LONG_PRESS_MS.
+ * - REPEAT     The key is still held after a long press. Repeats at the rate
+ *              set with input_repeat_set(), which is off by default.
+ * - DOUBLE     The key was pressed again within INPUT_DOUBLE_PRESS_MS of
+ *              being released. The press event is still sent first.
+ *
+ * The keypad and the buttons are timed separately, but only the key pressed
+ * last of each is timed. All of it shares one timeout, which only runs while
+ * a key is held or could still be double pressed.
+ *
+ * The events are sent by the keypad and buttons libraries, see their headers
+ * for the event values.
+*/
+
+#ifndef _input_h_
+#define _input_h_
+
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * Milliseconds a key has to be held to send a long press event.
+*/
+#define INPUT_LONG_PRESS_MS     600
+
+/**
+ * Milliseconds after a release in which a second press is a double press.
+*/
+#define INPUT_DOUBLE_PRESS_MS   300
+
+////////////////////////////////////////
+
+
+/**
+ * Milliseconds in a step of the input timer.
+ * All input timing is rounded to steps.
+*/
+#define INPUT_STEP_MS           50
+
+/**
+ * Convert milliseconds to input steps.
+*/
+#define INPUT_STEPS(ms)         ((unsigned char)((ms) / INPUT_STEP_MS))
+
+// Inputs that are timed.
+#define INPUT_KEYPAD            0
+#define INPUT_BUTTONS           1
+
+// Event data of each gesture. Gestures are or'd into the high nibble of the
+// keypad event type or the button event data.
+#define INPUT_GESTURE_LONG      0x30
+#define INPUT_GESTURE_REPEAT    0x40
+#define INPUT_GESTURE_DOUBLE    0x50
+
+/**
+ * Set the rate of repeat events while a key is held.
+ * This is reset to 0 (no repeats) every time the mode changes.
+ *
+ * @param[in]   steps   Steps between repeats, see INPUT_STEPS(). 0 disables
+ *                      repeating.
+*/
+void
+input_repeat_set (unsigned char steps);
+
+/**
+ * Start timing a key press.
+ * This is called by the keypad and buttons libraries from their ISRs.
+ *
+ * @param[in]   input   INPUT_KEYPAD or INPUT_BUTTONS.
+ * @param[in]   key     Event data of the key.
+*/
+void
+input_press (unsigned char input, unsigned char key);
+
+/**
+ * Stop timing a key press.
+ * This is called by the keypad and buttons libraries from their ISRs.
+ *
+ * @param[in]   input   INPUT_KEYPAD or INPUT_BUTTONS.
+ * @param[in]   key     Event data of the key.
+*/
+void
+input_release (unsigned char input, unsigned char key);
+
+#endif
+
+// EOF //
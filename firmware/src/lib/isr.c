@@ -47,7 +47,7 @@ isr_register (unsigned char int_flag, unsigned char int_mask, isr_func_t int_fun
     };
 
     signed char isr_index = -1;
-    if (MAX_SERVICE_ROUTINES >= interrupts_registered)
+    if (MAX_SERVICE_ROUTINES > interrupts_registered)
     {
         isr_index = interrupts_registered++;
         interrupts_service_routines[isr_index] = isr_to_register;
@@ -17,7 +17,7 @@
 ////////////////////////////////////////
 // Lib Config //
 
-#define MAX_SERVICE_ROUTINES    8
+#define MAX_SERVICE_ROUTINES    10
 
 ////////////////////////////////////////
 
@@ -0,0 +1,226 @@
+/** @file journal.c
+ * 
+ * Journaled EEPROM storage for CasiOS.
+*/
+
+#include "lib/eeprom.h"
+#include "lib/crc.h"
+
+#include "lib/journal.h"
+
+
+/** A record of the journal, in the order it is stored. */
+typedef struct
+{
+    unsigned char sequence;
+    unsigned char key;
+    unsigned char value_h;
+    unsigned char value_l;
+    unsigned char crc;
+} journal_record_t;
+
+/** Size of a record in EEPROM. */
+#define JOURNAL_RECORD_SIZE     5
+
+/** EEPROM address of a record. */
+#define JOURNAL_RECORD_ADDRESS(slot)    \
+    (unsigned char)(JOURNAL_ADDRESS + ((slot) * JOURNAL_RECORD_SIZE))
+
+/**
+ * Copy of every record in EEPROM, queued writes included. The journal is only
+ * read from EEPROM once on startup, so setting a value never has to wait on
+ * the EEPROM to read back records that are still queued.
+*/
+static journal_record_t journal_records[JOURNAL_RECORDS];
+
+/** Slot the next record is written to. */
+static unsigned char journal_head = 0;
+
+/** Sequence number of the next record. */
+static unsigned char journal_sequence = 0;
+
+/**
+ * Get a record from the copy and check it.
+ * 
+ * @returns     1 if the record is valid, 0 otherwise.
+*/
+static unsigned char journal_record_read (unsigned char slot, journal_record_t *record);
+
+/** CRC of a record. */
+static unsigned char journal_record_crc (journal_record_t *record);
+
+/** Check if a record is the newest of its key. */
+static unsigned char journal_record_live (unsigned char slot, unsigned char key);
+
+/** Write a record at the head of the ring. */
+static void journal_append (unsigned char key, unsigned int value);
+
+
+void
+journal_init (void)
+{
+    journal_record_t record;
+    journal_record_t next;
+
+    journal_head = 0;
+    journal_sequence = 0;
+
+    for (unsigned char slot = 0; slot < JOURNAL_RECORDS; slot++)
+    {
+        unsigned char address = JOURNAL_RECORD_ADDRESS(slot);
+
+        journal_records[slot].sequence = eeprom_read(address);
+        journal_records[slot].key = eeprom_read(address + 1);
+        journal_records[slot].value_h = eeprom_read(address + 2);
+        journal_records[slot].value_l = eeprom_read(address + 3);
+        journal_records[slot].crc = eeprom_read(address + 4);
+    }
+
+    // Records are written in slot order with incrementing sequence numbers.
+    // The newest record is the only valid one that the next slot doesn't
+    // continue, since that slot holds an older record, a broken record or
+    // nothing at all.
+    for (unsigned char slot = 0; slot < JOURNAL_RECORDS; slot++)
+    {
+        if (!journal_record_read(slot, &record))
+        {
+            continue;
+        }
+
+        if (!journal_record_read((slot + 1) % JOURNAL_RECORDS, &next)
+            || ((unsigned char)(record.sequence + 1) != next.sequence))
+        {
+            journal_head = (slot + 1) % JOURNAL_RECORDS;
+            journal_sequence = (unsigned char)(record.sequence + 1);
+            return;
+        }
+    }
+}
+
+unsigned char
+journal_get (unsigned char key, unsigned int *value)
+{
+    journal_record_t record;
+    unsigned char slot = journal_head;
+
+    // Newest to oldest.
+    for (unsigned char i = 0; i < JOURNAL_RECORDS; i++)
+    {
+        slot = (slot) ? slot - 1 : JOURNAL_RECORDS - 1;
+
+        if (journal_record_read(slot, &record) && (key == record.key))
+        {
+            *value = (unsigned int)(record.value_h << 8) | record.value_l;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void
+journal_set (unsigned char key, unsigned int value)
+{
+    journal_record_t record;
+    unsigned int current;
+
+    if (journal_get(key, &current) && (current == value))
+    {
+        // Nothing to write.
+        return;
+    }
+
+    // The slot at the head never holds a value that is still needed, so a
+    // write that doesn't finish can only lose the new value. The slot after
+    // it is overwritten next, so if that holds the newest record of another
+    // key, the record is copied to the head first. The journal holds less keys
+    // than records, so this always ends.
+    for (unsigned char i = 0; i < JOURNAL_RECORDS - 1; i++)
+    {
+        unsigned char next = (journal_head + 1) % JOURNAL_RECORDS;
+
+        if (!journal_record_read(next, &record)
+            || (key == record.key)
+            || !journal_record_live(next, record.key))
+        {
+            break;
+        }
+
+        journal_append(record.key, (unsigned int)(record.value_h << 8) | record.value_l);
+    }
+
+    journal_append(key, value);
+}
+
+
+static unsigned char
+journal_record_read (unsigned char slot, journal_record_t *record)
+{
+    *record = journal_records[slot];
+
+    return (journal_record_crc(record) == record->crc) ? 1 : 0;
+}
+
+static unsigned char
+journal_record_crc (journal_record_t *record)
+{
+    unsigned char crc = CRC8_INIT;
+
+    crc = crc8(crc, record->sequence);
+    crc = crc8(crc, record->key);
+    crc = crc8(crc, record->value_h);
+    crc = crc8(crc, record->value_l);
+
+    return crc;
+}
+
+static unsigned char
+journal_record_live (unsigned char slot, unsigned char key)
+{
+    journal_record_t record;
+    unsigned char newer = journal_head;
+
+    // Look for the key in every record newer than the slot.
+    while (1)
+    {
+        newer = (newer) ? newer - 1 : JOURNAL_RECORDS - 1;
+
+        if (newer == slot)
+        {
+            return 1;
+        }
+
+        if (journal_record_read(newer, &record) && (key == record.key))
+        {
+            return 0;
+        }
+    }
+}
+
+static void
+journal_append (unsigned char key, unsigned int value)
+{
+    journal_record_t record = {
+        .sequence = journal_sequence,
+        .key = key,
+        .value_h = (unsigned char)(value >> 8),
+        .value_l = (unsigned char)(value & 0xFF)
+    };
+    unsigned char address = JOURNAL_RECORD_ADDRESS(journal_head);
+
+    record.crc = journal_record_crc(&record);
+    journal_records[journal_head] = record;
+
+    // The CRC goes last, so a record that was only partly written fails the
+    // check.
+    eeprom_write(address, record.sequence);
+    eeprom_write(address + 1, record.key);
+    eeprom_write(address + 2, record.value_h);
+    eeprom_write(address + 3, record.value_l);
+    eeprom_write(address + 4, record.crc);
+
+    journal_head = (journal_head + 1) % JOURNAL_RECORDS;
+    journal_sequence++;
+}
+
+// EOF //
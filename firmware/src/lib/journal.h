@@ -0,0 +1,75 @@
+/** @file journal.h
+ * 
+ * Journaled EEPROM storage for CasiOS.
+ * 
+ * Values that change often would wear out a fixed EEPROM cell. The journal
+ * instead appends every change as a record to a ring in EEPROM, so the writes
+ * are spread across the whole region. The newest record of a key holds its
+ * value.
+ * 
+ * Each record is 5 bytes: a sequence number, the key, the 16-bit value and a
+ * CRC of the four. Records that fail the CRC, like one that was only half
+ * written when the watch reset, are ignored. Both bytes of a value are always
+ * written in the same record, so a value is never half updated. On startup
+ * the head of the ring is found by scanning each record once.
+ * 
+ * The slot at the head of the ring is always free. Before the slot after it is
+ * used, it is checked for holding the newest record of a key. If it does, the
+ * record is copied to the head first. This way values are never lost to the
+ * ring wrapping around or to a record that was only partly written. This means
+ * the journal can hold at most JOURNAL_RECORDS - 2 different keys.
+*/
+
+#ifndef _journal_h_
+#define _journal_h_
+
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * EEPROM address of the journal.
+ * The journal occupies JOURNAL_RECORDS * 5 bytes from this address.
+*/
+#define JOURNAL_ADDRESS         0x80
+
+/**
+ * Number of records in the journal.
+*/
+#define JOURNAL_RECORDS         12
+
+////////////////////////////////////////
+
+
+/**
+ * Initialize the journal.
+ * 
+ * This finds the head of the ring.
+*/
+void
+journal_init (void);
+
+/**
+ * Get the value of a key.
+ * 
+ * @param[in]   key     Key to look up.
+ * @param[out]  value   Set to the value of the key, if it has one.
+ * 
+ * @returns     1 if the key has a value, 0 if it has never been set.
+*/
+unsigned char
+journal_get (unsigned char key, unsigned int *value);
+
+/**
+ * Set the value of a key.
+ * 
+ * The record is written through the EEPROM write queue (eeprom.h).
+ * 
+ * @param[in]   key     Key to set.
+ * @param[in]   value   Value to set.
+*/
+void
+journal_set (unsigned char key, unsigned int value);
+
+#endif
+
+// EOF //
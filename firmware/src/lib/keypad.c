@@ -11,6 +11,8 @@
 
 #include "lib/isr.h"
 #include "lib/events.h"
+#include "lib/timeout.h"
+#include "lib/input.h"
 
 #include "lib/keypad.h"
 
@@ -25,31 +27,63 @@
 #define KEYPAD_ROW_3             PORTABITS.RA3   // row 3 - RA3
 
 // Column Pins Configuration.
+// The column pins are packed into a nibble with KEYPAD_COLUMN_INDEX(), which
+// indexes the keypad_columns table to get a bit for each column that is low.
 #if (1 == PCB_REV)
 #   define KEYPAD_COLUMN_MASK      0xC3
 #   define KEYPAD_COLUMN_PORT      PORTC
-#   define KEYPAD_COLUMN_0         PORTCbits.RC1   // col 0 - RC1
-#   define KEYPAD_COLUMN_1         PORTCbits.RC0   // col 1 - RC0
-#   define KEYPAD_COLUMN_2         PORTCbits.RC6   // col 2 - RC6
-#   define KEYPAD_COLUMN_3         PORTCbits.RC7   // col 3 - RC7
 #   define KEYPAD_COLUMN_INTF      IOCCF
+
+// RC0, RC1, RC6, RC7 -> col 1, col 0, col 2, col 3
+#   define KEYPAD_COLUMN_INDEX(pins)   (((pins) & 0x03) | (((pins) >> 4) & 0x0C))
+
+static const unsigned char keypad_columns[16] = {
+    0x0, 0x2, 0x1, 0x3, 0x4, 0x6, 0x5, 0x7,
+    0x8, 0xA, 0x9, 0xB, 0xC, 0xE, 0xD, 0xF,
+};
 #endif
 
 #if (2 <= PCB_REV)
 #   define KEYPAD_COLUMN_MASK      0xCC
 #   define KEYPAD_COLUMN_PORT      PORTC    
-#   define KEYPAD_COLUMN_0         PORTCbits.RC6   // col 0 - RC6
-#   define KEYPAD_COLUMN_1         PORTCbits.RC7   // col 1 - RC7
-#   define KEYPAD_COLUMN_2         PORTCbits.RC2   // col 2 - RC2
-#   define KEYPAD_COLUMN_3         PORTCbits.RC3   // col 3 - RC3
 #   define KEYPAD_COLUMN_INTF      IOCCF
+
+// RC6, RC7, RC2, RC3 -> col 0, col 1, col 2, col 3
+#   define KEYPAD_COLUMN_INDEX(pins)   ((((pins) >> 6) & 0x03) | ((pins) & 0x0C))
+
+static const unsigned char keypad_columns[16] = {
+    0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7,
+    0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF,
+};
 #endif
 
+/**
+ * Time to let the contacts settle after a key changes, in timeout ticks.
+ * Pin changes are ignored until the keypad is scanned again after this.
+*/
+#define KEYPAD_DEBOUNCE_PERIOD  TIMEOUT_MS(20)
+
+/**
+ * How often the keypad is scanned while keys are held, in timeout ticks.
+ * Pressing a key in the same column as a held key doesn't change any column
+ * pin, so there is no interrupt for it.
+*/
+#define KEYPAD_HOLD_PERIOD      TIMEOUT_MS(100)
 
-// We only support one key at a time. So these variables are used to emit a key
-// release event.
-static unsigned char keypad_lastkey = 0;
-static unsigned char keypad_keystate = 0;
+/**
+ * Keys that are currently down.
+ * Bit n is set while the key with raw keycode n is down.
+*/
+static volatile unsigned int keypad_state = 0;
+
+/**
+ * Keycode each key emitted when it was pressed.
+ * The release emits the same keycode, even if the keymap changed since.
+*/
+static unsigned char keypad_keycodes[16];
+
+/** Set while waiting for the contacts to settle. */
+static volatile unsigned char keypad_debouncing = 0;
 
 /** Currently configured keymap. */
 static char keypad_keymap = 0;
@@ -60,14 +94,32 @@ static const char keypad_keymaps_total = sizeof(keypad_keymaps);
 
 void keypad_isr (void);
 
+/**
+ * Read the whole key matrix.
+ * 
+ * @returns     The keys that are down, in the same format as keypad_state.
+*/
+static unsigned int keypad_scan (void);
+
+/**
+ * Emit events for every key that changed since the last scan.
+*/
+static void keypad_update (unsigned int state);
+
+/**
+ * Scan the keypad after debouncing and while keys are held.
+ * Called from the timeout interrupt.
+*/
+static void keypad_timeout (void);
+
 
 void
 keypad_init (void)
 {
     // Setup default state
     //
-    keypad_lastkey = 0;
-    keypad_keystate = 0;
+    keypad_state = 0;
+    keypad_debouncing = 0;
     keypad_keymap = 0;
 
     // Disable IOC interrupts while configuring pins.
@@ -117,41 +169,39 @@ keypad_keymap_get (void)
 /**
  * Emit a key press event based on the given keycode.
  * 
- * This also sets a flag to later determine if a key is down.
+ * The keycode is mapped with the current keymap and remembered for the
+ * release event.
 */
-void
+static void
 keypad_keypress (unsigned char keycode)
 {
-    // Get our mapped keycode from the current keymap.
+    // A keymap of 0 returns the raw keycodes so we don't have to get one from
+    // a keymap.
     //
     if (keypad_keymap)
     {
-        keypad_lastkey = keypad_keymaps[keypad_keymap][keycode];
+        keypad_keycodes[keycode] = keypad_keymaps[keypad_keymap][keycode];
     }
-
-    // A keymap of 0 returns the raw keycodes so we don't have to get one from
-    // a keymap.
-    //
     else
     {
-        keypad_lastkey = keycode;
+        keypad_keycodes[keycode] = keycode;
     }
 
-    // Key down flag
-    keypad_keystate = 1;
-
     // Emit keypress event
-    event_isr((unsigned int)EVENT_ID(KEYPAD_EVENT_PRESS, keypad_lastkey));
+    event_isr((unsigned int)EVENT_ID(KEYPAD_EVENT_PRESS, keypad_keycodes[keycode]));
+
+    input_press(INPUT_KEYPAD, keypad_keycodes[keycode]);
 }
 
 /**
- * Emit a key release event.
+ * Emit a key release event with the keycode the key was pressed with.
 */
-void
-keypad_keyrelease (void)
+static void
+keypad_keyrelease (unsigned char keycode)
 {
-    keypad_keystate = 0;
-    event_isr((unsigned int)EVENT_ID(KEYPAD_EVENT_RELEASE, keypad_lastkey));
+    event_isr((unsigned int)EVENT_ID(KEYPAD_EVENT_RELEASE, keypad_keycodes[keycode]));
+
+    input_release(INPUT_KEYPAD, keypad_keycodes[keycode]);
 }
 
 void
@@ -161,71 +211,123 @@ keypad_isr (void)
     //
     if (KEYPAD_COLUMN_INTF & KEYPAD_COLUMN_MASK)
     {
-        // Key release
-        if (keypad_keystate)
+        // Edges while the contacts are bouncing are ignored, the scan after
+        // debouncing picks up where the keys settled.
+        //
+        if (!keypad_debouncing)
         {
-            keypad_keyrelease();
+            keypad_update(keypad_scan());
         }
 
-        // Key press
-        else
-        {
+        // Clear column IOC flag
+        //
+        KEYPAD_COLUMN_INTF &= ~(KEYPAD_COLUMN_MASK);
+    }
+}
 
-            signed char column = -1;
-            unsigned char row = 0;
+static unsigned int
+keypad_scan (void)
+{
+    unsigned int state = 0;
 
-            // Loop through rows and check the columns.
-            //
-            for (row = 0; row < 4; row++)
-            {
+    // Loop through rows and read all columns at once. Rows are scanned from
+    // the bottom up so row 0 ends up in the lowest nibble.
+    //
+    for (signed char row = 3; row >= 0; row--)
+    {
+        // Set all rows high
+        //
+        pin_mask_high(KEYPAD_ROW_LAT, KEYPAD_ROW_MASK);
 
-                // Set all rows high
-                //
-                pin_mask_high(KEYPAD_ROW_LAT, KEYPAD_ROW_MASK);
-
-                // Set given row low
-                //
-                pin_set_low(KEYPAD_ROW_LAT, row);
-
-                // Check columns.
-                //
-                if (0 < (~KEYPAD_COLUMN_PORT & KEYPAD_COLUMN_MASK))
-                {
-                    if (0 == KEYPAD_COLUMN_0)
-                    {
-                        column = 0;
-                    }
-                    else if (0 == KEYPAD_COLUMN_1)
-                    {
-                        column = 1;
-                    }
-                    else if (0 == KEYPAD_COLUMN_2)
-                    {
-                        column = 2;
-                    }
-                    else if (0 == KEYPAD_COLUMN_3)
-                    {
-                        column = 3;
-                    }
-
-                    if (-1 < column)
-                    {
-                        // Keycodes are 0-15 starting from the top left going right
-                        //
-                        keypad_keypress((unsigned char)((row * 4) + column));
-                    }
-                }
-            }
+        // Set given row low
+        //
+        pin_set_low(KEYPAD_ROW_LAT, row);
+
+        // Columns of keys that are down in this row are pulled low.
+        //
+        state <<= 4;
+        state |= keypad_columns[KEYPAD_COLUMN_INDEX(~KEYPAD_COLUMN_PORT & KEYPAD_COLUMN_MASK)];
+    }
+
+    // Set rows to default LOW state
+    //
+    pin_mask_low(KEYPAD_ROW_LAT, KEYPAD_ROW_MASK);
 
-            // Set rows to default LOW state
-            //
-            pin_mask_low(KEYPAD_ROW_LAT, KEYPAD_ROW_MASK);
+    return state;
+}
+
+static void
+keypad_update (unsigned int state)
+{
+    unsigned int changed = state ^ keypad_state;
+    unsigned int bit = 1;
+    unsigned char pressed = 0;
+    unsigned char held = 0;
+    unsigned char chord = 0;
+
+    keypad_state = state;
+
+    // Keycodes are 0-15 starting from the top left going right
+    //
+    for (unsigned char keycode = 0; keycode < 16; keycode++, bit <<= 1)
+    {
+        if (state & bit)
+        {
+            // Remember the keys that are down for a chord.
+            chord = (unsigned char)(chord << 4) | keycode;
+            held++;
         }
-        
-        // Clear column IOC flag
+
+        if (changed & bit)
+        {
+            if (state & bit)
+            {
+                keypad_keypress(keycode);
+                pressed = 1;
+            }
+            else
+            {
+                keypad_keyrelease(keycode);
+            }
+        }
+    }
+
+    // A key was pressed while exactly one other key was held.
+    //
+    if (pressed && (2 == held))
+    {
+        event_isr((unsigned int)EVENT_ID(KEYPAD_EVENT_CHORD, chord));
+    }
+
+    if (changed)
+    {
+        // Confirm the new state once the contacts have settled.
         //
-        KEYPAD_COLUMN_INTF &= ~(KEYPAD_COLUMN_MASK);
+        keypad_debouncing = 1;
+        timeout_set(&keypad_timeout, KEYPAD_DEBOUNCE_PERIOD);
+    }
+    else if (state)
+    {
+        // Keep an eye on the matrix while keys are held.
+        //
+        timeout_set(&keypad_timeout, KEYPAD_HOLD_PERIOD);
+    }
+    else
+    {
+        timeout_cancel(&keypad_timeout);
     }
 }
 
+static void
+keypad_timeout (void)
+{
+    keypad_debouncing = 0;
+
+    keypad_update(keypad_scan());
+
+    // Changing the rows sets the column IOC flags, but nothing was pressed.
+    //
+    KEYPAD_COLUMN_INTF &= ~(KEYPAD_COLUMN_MASK);
+}
+
 /* EOF */
@@ -2,11 +2,16 @@
  * 
  * This library implements the 4x4 16-key keypad on the watch.
  * 
- * Each key generates events on press and release.
+ * Each key generates events on press and release, and any number of keys can
+ * be down at the same time. Pressing a key while exactly one other key is
+ * held also generates a chord event. The keypad has no diodes, so three keys
+ * in the corners of a rectangle make the fourth corner look pressed too.
  * The keycode each key generates is configurable via the 'keymap' mode_config
- * option.
+ * option. The last key pressed also generates long press, repeat and double
+ * press events, see lib/input.h.
  * 
- * TODO: No debouncing is implemented for the button presses.
+ * Keys are debounced by ignoring pin changes for a short time after a key
+ * changes, then scanning the keypad once more to confirm where it settled.
 */
 
 #ifndef _keypad_h_
@@ -19,6 +24,18 @@
 //
 #define KEYPAD_EVENT_PRESS      0x0C
 #define KEYPAD_EVENT_RELEASE    0x1C
+#define KEYPAD_EVENT_CHORD      0x2C
+#define KEYPAD_EVENT_LONG       0x3C    // See lib/input.h
+#define KEYPAD_EVENT_REPEAT     0x4C
+#define KEYPAD_EVENT_DOUBLE     0x5C
+
+/**
+ * Data of the chord event of two keys.
+ * Chords always use the raw keycodes (0-15, starting from the top left going
+ * right) no matter the keymap, and the order the keys were pressed in does
+ * not matter. e.g. '/' and '=' on the casio keymap is KEYPAD_CHORD(3, 14).
+*/
+#define KEYPAD_CHORD(a, b)      (((a) < (b)) ? (((a) << 4) | (b)) : (((b) << 4) | (a)))
 
 /**
  * Initialize the keypad.
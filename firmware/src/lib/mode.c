@@ -9,6 +9,7 @@
 #include "lib/tick.h"
 #include "lib/buttons.h"
 #include "lib/keypad.h"
+#include "lib/input.h"
 #include "lib/display.h"
 
 #include "modes/mode_config.h"
@@ -21,11 +22,52 @@
 /** This value holds the currently selected mode. */
 static unsigned char mode_selected = 0;
 
+// Gestures of an input event, besides the ones in lib/input.h.
+#define MODE_GESTURE_PRESS      0x00
+#define MODE_GESTURE_RELEASE    0x10
+
+// How far along the key that woke the display is.
+#define MODE_WAKE_NONE          0   // No key woke the display.
+#define MODE_WAKE_HELD          1   // Held down since it woke the display.
+#define MODE_WAKE_RELEASED      2   // Released, could still be pressed again.
+#define MODE_WAKE_PRESSED       3   // Pressed again, a double press may follow.
+
+/** Key that woke the display, see mode_input_key(). */
+static unsigned int mode_wake_key = 0;
+
+/** State of the key that woke the display. */
+static unsigned char mode_wake_state = MODE_WAKE_NONE;
+
+/**
+ * Check if an input event belongs to the key that woke the display.
+ * The press that wakes the display is only meant to wake it, so the mode
+ * doesn't see it. Neither does it see the rest of that press: the release,
+ * any long press or repeat, and a double press that follows it.
+ * 
+ * @returns     1 if the mode should not see the event.
+*/
+static unsigned char
+mode_wake_swallow (unsigned int event);
+
+// Key of an input event, the same for all of its gestures.
+#define mode_input_key(event)                                               \
+    ((EVENT_BUTTON == EVENT_TYPE(event)) ?                                  \
+        EVENT_ID(EVENT_BUTTON, EVENT_DATA(event) & 0x0F) :                  \
+        EVENT_ID(EVENT_KEYPAD, EVENT_DATA(event)))
+
+// Gesture of an input event.
+#define mode_input_gesture(event)                                           \
+    ((EVENT_BUTTON == EVENT_TYPE(event)) ?                                  \
+        (EVENT_DATA(event) & 0xF0) :                                        \
+        (EVENT_TYPE(event) & 0xF0))
+
 /**
  * Reset various libs to defaults.
  * This reset libraries that are configurable by mode applications including:
  * - tickrate
  * - keypad keymap
+ * - key repeat rate
+ * - display blinking and scrolling
 */
 static void
 mode_config_defaults (void);
@@ -107,8 +149,31 @@ mode_thread (void)
     {
         LOG_DEBUG("Handling event: x%.4x", event);
 
+        // Input keeps the display awake. Input that turns the display back
+        // on is only meant to wake it, so the mode never sees that key press.
+        // The daemons still get every event.
+        unsigned char swallow = 0;
+
+        if ((EVENT_BUTTON == EVENT_TYPE(event)) ||
+            (EVENT_KEYPAD == (EVENT_TYPE(event) & 0x0F)))
+        {
+            swallow = mode_wake_swallow(event);
+
+            if (display_wake() && (KEYPAD_EVENT_CHORD != EVENT_TYPE(event)))
+            {
+                mode_wake_key = mode_input_key(event);
+                mode_wake_state = (MODE_GESTURE_RELEASE == mode_input_gesture(event)) ?
+                    MODE_WAKE_RELEASED : MODE_WAKE_HELD;
+                swallow = 1;
+            }
+        }
+        else if (EVENT_ALARM == EVENT_TYPE(event))
+        {
+            display_wake();
+        }
+
         // Call mode's run function with the event.
-        if (mode_list[mode_selected]->run(event))
+        if (!swallow && mode_list[mode_selected]->run(event))
         {
             // If the mode returns 1, we switch to the next mode
             mode_next();
@@ -129,6 +194,46 @@ mode_thread (void)
 }
 
 
+static unsigned char
+mode_wake_swallow (unsigned int event)
+{
+    unsigned char gesture = mode_input_gesture(event);
+
+    if ((MODE_WAKE_NONE == mode_wake_state)
+        || (KEYPAD_EVENT_CHORD == EVENT_TYPE(event))
+        || (mode_input_key(event) != mode_wake_key))
+    {
+        return 0;
+    }
+
+    switch (mode_wake_state)
+    {
+        case MODE_WAKE_HELD:
+            if (MODE_GESTURE_RELEASE == gesture)
+            {
+                mode_wake_state = MODE_WAKE_RELEASED;
+            }
+            return 1;
+
+        case MODE_WAKE_RELEASED:
+            if (MODE_GESTURE_PRESS == gesture)
+            {
+                // A new press the mode should see, but its double press
+                // would count the press that woke the display.
+                mode_wake_state = MODE_WAKE_PRESSED;
+                return 0;
+            }
+        break;
+
+        case MODE_WAKE_PRESSED:
+            mode_wake_state = MODE_WAKE_NONE;
+            return (INPUT_GESTURE_DOUBLE == gesture);
+    }
+
+    mode_wake_state = MODE_WAKE_NONE;
+    return 0;
+}
+
 static void
 mode_config_defaults (void)
 {
@@ -139,11 +244,18 @@ mode_config_defaults (void)
     // Default keypad keymap: Casio
     keypad_keymap_set(KEYMAP_CASIO);
 
+    // Default key repeat: Held keys don't repeat
+    input_repeat_set(0);
+
     // Default Display: Blank primary, secondary, and punctuations displays.
     // The sign & misc displays are not touched so they can be 'notifications'.
     display_primary_clear(0);
     display_secondary_clear(0);
     display_period_clear(0);
+
+    // Default blinking: Nothing blinks or scrolls
+    display_blink_clear();
+    display_scroll_stop();
 }
 
 // EOF //
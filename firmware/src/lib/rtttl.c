@@ -0,0 +1,255 @@
+/** @file rtttl.c
+ * 
+ * Runtime RTTTL parser for the buzzer library.
+ * 
+ * This is only compiled if BUZZER_RTTTL_PARSER is set in lib/buzzer.h.
+*/
+
+#include <xc.h>
+
+#include "drivers/pwm.h"
+#include "lib/buzzer.h"
+
+#define LOG_TAG "lib.rtttl"
+#include "lib/logging.h"
+
+#if BUZZER_RTTTL_PARSER
+
+#define IS_ALPHA(c) (('A' <= (c) && (c) <= 'Z') || ('a' <= (c) && (c) <= 'z'))
+#define IS_NUM(c)   ('0' <= (c) && (c) <= '9')
+
+/** Volume of RTTTL notes as a percentage. */
+#define RTTTL_PARSER_VOLUME     25
+
+/**
+ * Timer settings of a note in the 7th octave, worked out at compile time.
+ * Each octave down doubles the period, which is one more prescaler step with
+ * the same period and duty cycle.
+*/
+#define NOTE(freq)  { PWM_PERIOD(freq), PWM_PRESCALER(freq),                \
+                      PWM_DUTY(freq, RTTTL_PARSER_VOLUME / 2) }
+
+static const struct
+{
+    unsigned char period;
+    unsigned char prescaler;
+    unsigned char duty;
+} Notes[] = {
+    NOTE(NOTE_C7), NOTE(NOTE_CS7), NOTE(NOTE_D7), NOTE(NOTE_DS7),
+    NOTE(NOTE_E7), NOTE(NOTE_F7), NOTE(NOTE_FS7), NOTE(NOTE_G7),
+    NOTE(NOTE_GS7), NOTE(NOTE_A7), NOTE(NOTE_AS7), NOTE(NOTE_B7)
+};
+
+void
+buzzer_play_rtttl(char * rtttl_str)
+{
+    unsigned char song_title[10];
+    unsigned int char_index = 0;
+
+    // Get first 10 characters of title
+    while (rtttl_str[char_index] != ':')
+    {
+        if (char_index < sizeof(song_title))
+        {
+            song_title[char_index] = rtttl_str[char_index];
+        }
+        char_index++;
+    }
+    char_index++;   // Skip colon
+
+    // Get note defaults
+    unsigned char song_def_duration = 4;
+    unsigned char song_def_octave = 6;
+    unsigned int song_def_bpm = 63;
+    while (rtttl_str[char_index] != ':')
+    {
+        switch (rtttl_str[char_index])
+        {
+        case 'd':
+            char_index += 2;    // Consume 'b='
+            // Set duration
+            song_def_duration = 0;
+            while (IS_NUM(rtttl_str[char_index]))
+            {
+                song_def_duration = (song_def_duration * 10) \
+                    + (rtttl_str[char_index++] - 48);
+            }
+        break;
+
+        case 'o':
+            char_index += 2;    // Consume 'o='
+            // Set octave
+            song_def_octave = rtttl_str[char_index++] - 48;
+        break;
+
+        case 'b':
+            char_index += 2;    // Consume 'b='
+            // Set bpm
+            song_def_bpm = 0;
+            while (IS_NUM(rtttl_str[char_index]))
+            {
+                song_def_bpm = (song_def_bpm * 10) \
+                    + (rtttl_str[char_index++] - 48);
+            }
+        break;
+        
+        default:
+            // Unrecognized command, we'll skip it in a few loops.
+            char_index++;
+        break;
+        }
+    }
+    char_index++;   // Skip colon
+
+    // Print info
+    LOG_INFO("Now Playing: %s", song_title);
+    LOG_DEBUG("in octave: %u", song_def_octave);
+    LOG_DEBUG("note len: %u", song_def_duration);
+    LOG_DEBUG("BPM: %u", song_def_bpm);
+
+    // Needed values
+    unsigned int note_length_ms = (unsigned)((60000U/song_def_bpm)*4);
+    unsigned char note_duration;
+    unsigned char note_pitch;
+    unsigned char note_sharp;
+    unsigned char note_octave;
+
+    // Play notes until end of string is reached
+    while (rtttl_str[char_index])
+    {
+        // Check if duration is present
+        if (IS_NUM(rtttl_str[char_index]))
+        {
+            // Get duration of note
+            note_duration = rtttl_str[char_index++] - 48;
+            if (IS_NUM(rtttl_str[char_index]))
+            {
+                note_duration = (note_duration * 10) \
+                    + (rtttl_str[char_index++] - 48);
+            }
+        }
+        else
+        {
+            // Go with default duration
+            note_duration = song_def_duration;
+        }
+
+        // Get the pitch
+        // note_pitch = rtttl_str[char_index++];
+        switch (rtttl_str[char_index++])
+        {
+            case 'c':
+            case 'C':
+                note_pitch = 0;
+            case 'd':
+            case 'D':
+                note_pitch = 2;
+            break;
+
+            case 'e':
+            case 'E':
+                note_pitch = 4;
+            break;
+
+            case 'f':
+            case 'F':
+                note_pitch = 5;
+            break;
+
+            case 'g':
+            case 'G':
+                note_pitch = 7;
+            break;
+
+            case 'a':
+            case 'A':
+                note_pitch = 9;
+            break;
+
+            case 'b':
+            case 'h':
+            case 'B':
+            case 'H':
+                note_pitch = 11;
+            break;
+
+            default:
+                note_pitch = 50;
+            break;
+        }
+        // Check for sharps
+        if (rtttl_str[char_index] == '#')
+        {
+            note_sharp = '#';
+            note_pitch++;
+            char_index++;
+        }
+        else
+        {
+            note_sharp = ' ';
+        }
+
+        // Check for period for special-duration
+        if (rtttl_str[char_index] == '.')
+        {
+            // Increase duration by 50%
+            note_duration += note_duration / 2;
+            char_index++;   // Consume '.'
+        }
+
+        // Check for octave specifier
+        if (IS_NUM(rtttl_str[char_index]))
+        {
+            note_octave = rtttl_str[char_index++] - 48;
+        }
+        else
+        {
+            // Go with default octave
+            note_octave = song_def_octave;
+        }
+
+        // Skip comma
+        if (rtttl_str[char_index] == ',')
+        {
+            char_index++;   // Consume ','
+        }
+
+        // Play note
+        if ((note_pitch < 12) && (note_octave <= 7)
+            && (Notes[note_pitch].prescaler + (7 - note_octave) < 8))
+        {
+            unsigned int pause_duration = (unsigned)((note_length_ms / note_duration) >> 4);
+            unsigned int tone_duration = (unsigned)((note_length_ms / note_duration) - pause_duration);
+            LOG_DEBUG("Playing note: %u%c%u for %ums, pause %ums", note_pitch, note_sharp, note_octave, tone_duration, pause_duration);
+            pwm_timer_set(Notes[note_pitch].period,
+                (unsigned char)(Notes[note_pitch].prescaler + (7 - note_octave)));
+            pwm_duty_raw_set(Notes[note_pitch].duty);
+            pwm_enable();
+            int delay_count = 0;
+            while (delay_count++ < tone_duration)
+            {
+                __delay_us(990);
+            }
+            pwm_disable();
+            delay_count = 0;
+            while (delay_count++ < pause_duration)
+            {
+                __delay_us(990);
+            }
+        }
+        else
+        {
+            // Rest
+            LOG_DEBUG("Resting for %ums", (note_length_ms / note_duration));
+            int delay_count = 0;
+            while (delay_count++ < (note_length_ms / note_duration))
+            {
+                __delay_us(990);
+            }
+        }
+    }
+}
+
+#endif
+
+// EOF //
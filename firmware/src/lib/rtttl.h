@@ -0,0 +1,98 @@
+/** @file rtttl.h
+ * 
+ * Compile time RTTTL songs for the buzzer library.
+ * 
+ * RTTTL ringtones are written as a list of notes, each with a duration (as a
+ * division of a whole note), a pitch and an octave. The macros here turn each
+ * note into a buzzer_note_t when the firmware is compiled, so a song is just a
+ * table of notes in flash and playing it needs no parsing or calculations.
+ * 
+ * Like the runtime parser, each note is followed by a short gap of 1/16 of its
+ * duration so repeated notes can be told apart.
+ * 
+ * The tempo is passed into each song, so the same song can be played at
+ * different speeds:
+ * 
+ *  static const buzzer_note_t song[] = { RTTTL_MARIO(200) };
+ *  buzzer_play(song, sizeof(song) / sizeof(song[0]));
+*/
+
+#ifndef _rtttl_h_
+#define _rtttl_h_
+
+#include "lib/buzzer.h"
+
+/** Volume of RTTTL notes as a percentage. */
+#define RTTTL_VOLUME            25
+
+/** Milliseconds of a note of a division of a whole note at a tempo. */
+#define RTTTL_MS(division, bpm)         (((60000UL / (bpm)) * 4) / (division))
+
+/** Frequency of a pitch (C, CS, D, ... B) in an octave (4-7). */
+#define RTTTL_FREQ(pitch, octave)       ((NOTE_##pitch##7 >> (7 - (octave))) + 1)
+
+/**
+ * A note of a pitch and octave lasting a division of a whole note.
+*/
+#define RTTTL_NOTE(pitch, octave, division, bpm)                            \
+    BUZZER_NOTE(RTTTL_FREQ(pitch, octave), RTTTL_VOLUME,                    \
+        RTTTL_MS(division, bpm) - (RTTTL_MS(division, bpm) >> 4),           \
+        RTTTL_MS(division, bpm) >> 4)
+
+/**
+ * A dotted note, which lasts half again as long.
+*/
+#define RTTTL_DOTTED(pitch, octave, division, bpm)                          \
+    BUZZER_NOTE(RTTTL_FREQ(pitch, octave), RTTTL_VOLUME,                    \
+        RTTTL_MS(division, bpm) * 3 / 2 - (RTTTL_MS(division, bpm) * 3 >> 5), \
+        RTTTL_MS(division, bpm) * 3 >> 5)
+
+/**
+ * A pause lasting a division of a whole note.
+*/
+#define RTTTL_REST(division, bpm)       BUZZER_REST(RTTTL_MS(division, bpm))
+
+
+ //////////////////////////////////////////////////////////////////////////////
+// Songs
+
+/**
+ * Super Mario Bros theme.
+ * Mario:d=4,o=5:32p,16e6,16e6,16p,16e6,16p,16c6,16e6,16p,16g6,8p,16p,16g,...
+*/
+#define RTTTL_MARIO(bpm)                                                    \
+    RTTTL_REST(32, bpm), RTTTL_NOTE(E, 6, 16, bpm),                         \
+    RTTTL_NOTE(E, 6, 16, bpm), RTTTL_REST(16, bpm),                         \
+    RTTTL_NOTE(E, 6, 16, bpm), RTTTL_REST(16, bpm),                         \
+    RTTTL_NOTE(C, 6, 16, bpm), RTTTL_NOTE(E, 6, 16, bpm),                   \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(G, 6, 16, bpm),                         \
+    RTTTL_REST(8, bpm), RTTTL_REST(16, bpm),                                \
+    RTTTL_NOTE(G, 5, 16, bpm), RTTTL_REST(8, bpm),                          \
+    RTTTL_REST(32, bpm), RTTTL_NOTE(C, 6, 16, bpm),                         \
+    RTTTL_REST(8, bpm), RTTTL_NOTE(G, 5, 16, bpm),                          \
+    RTTTL_REST(8, bpm), RTTTL_NOTE(E, 5, 16, bpm),                          \
+    RTTTL_REST(8, bpm), RTTTL_NOTE(A, 5, 16, bpm),                          \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(B, 5, 16, bpm),                         \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(AS, 5, 16, bpm),                        \
+    RTTTL_NOTE(A, 5, 16, bpm), RTTTL_REST(16, bpm),                         \
+    RTTTL_NOTE(G, 5, 16, bpm), RTTTL_NOTE(E, 6, 16, bpm),                   \
+    RTTTL_NOTE(G, 6, 16, bpm), RTTTL_NOTE(A, 6, 16, bpm),                   \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(F, 6, 16, bpm),                         \
+    RTTTL_NOTE(G, 6, 16, bpm), RTTTL_REST(16, bpm),                         \
+    RTTTL_NOTE(E, 6, 16, bpm), RTTTL_REST(16, bpm),                         \
+    RTTTL_NOTE(C, 6, 16, bpm), RTTTL_NOTE(D, 6, 16, bpm),                   \
+    RTTTL_NOTE(B, 5, 16, bpm), RTTTL_REST(4, bpm),                          \
+    RTTTL_NOTE(G, 6, 16, bpm), RTTTL_NOTE(FS, 6, 16, bpm),                  \
+    RTTTL_NOTE(F, 6, 16, bpm), RTTTL_NOTE(DS, 6, 16, bpm),                  \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(E, 6, 16, bpm),                         \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(GS, 5, 16, bpm),                        \
+    RTTTL_NOTE(A, 5, 16, bpm), RTTTL_NOTE(C, 6, 16, bpm),                   \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(A, 5, 16, bpm),                         \
+    RTTTL_NOTE(C, 6, 16, bpm), RTTTL_NOTE(D, 6, 16, bpm),                   \
+    RTTTL_REST(8, bpm), RTTTL_NOTE(DS, 6, 8, bpm),                          \
+    RTTTL_REST(16, bpm), RTTTL_NOTE(D, 6, 16, bpm),                         \
+    RTTTL_REST(8, bpm), RTTTL_NOTE(C, 6, 8, bpm)
+
+#endif
+
+// EOF //
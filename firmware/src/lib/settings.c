@@ -3,37 +3,264 @@
  * Persistent settings lib for CasiOS.
 */
 
-#include "drivers/nvm.h"
+#include "lib/eeprom.h"
+#include "lib/journal.h"
+#include "lib/crc.h"
+
+#include "modes/mode_settings.h"
 
 #include "lib/settings.h"
 
+#define LOG_TAG "lib.settings"
+#include "lib/logging.h"
+
+
+/** Type, default and range of a setting. */
+typedef struct
+{
+    unsigned char type;
+    unsigned char def;
+    unsigned char min;
+    unsigned char max;
+} settings_def_t;
+
+#define SETTINGS_DEF(id, type, def, min, max)   \
+    [id] = { type, (unsigned char)(def), (unsigned char)(min), (unsigned char)(max) },
+
+/** Every setting reserved by modes, built from MODE_SETTINGS(). */
+static const settings_def_t settings_registry[MODE_SETTINGS_MAX] = {
+    MODE_SETTINGS(SETTINGS_DEF)
+};
+
+/** Copy of the settings reserved by modes. */
+static unsigned char settings_cache[MODE_SETTINGS_MAX];
+
+/**
+ * What is stored in EEPROM at each setting's address, queued writes included.
+ * Flushing compares against this, so it never has to wait on the EEPROM to
+ * read back what it just queued.
+*/
+static unsigned char settings_stored[MODE_SETTINGS_MAX];
+
+/** What is stored in EEPROM for the version and CRC. */
+static unsigned char settings_stored_version;
+static unsigned char settings_stored_crc;
+
+/** One bit for every cached setting that hasn't been written back yet. */
+static unsigned char settings_dirty[(MODE_SETTINGS_MAX + 7) / 8];
+
+#define SETTINGS_DIRTY_BYTE(id)     settings_dirty[(id) >> 3]
+#define SETTINGS_DIRTY_BIT(id)      (unsigned char)(1 << ((id) & 0x07))
+
+/** Check if a setting is either byte of a journaled setting. */
+#define SETTINGS_JOURNALED(id)      \
+    (SETTING_JOURNALED(id) || SETTING_JOURNALED((id) - 1))
+
+/** Journal key of a journaled setting, the ID of its H byte. */
+#define SETTINGS_JOURNAL_KEY(id)    \
+    (unsigned char)(SETTING_JOURNALED(id) ? (id) : (id) - 1)
+
+/** Check if a value is in the range of a setting. */
+static unsigned char settings_valid (unsigned char id, unsigned char value);
+
+/** CRC of the version and every cached setting at a fixed address. */
+static unsigned char settings_crc (void);
+
+
+void
+settings_load (void)
+{
+    unsigned char id;
+    unsigned char intact;
+    unsigned char blank;
+    unsigned int value;
+
+    for (id = 0; id < MODE_SETTINGS_MAX; id++)
+    {
+        settings_cache[id] = eeprom_read(id);
+        settings_stored[id] = settings_cache[id];
+    }
+
+    settings_stored_version = eeprom_read(SETTINGS_HEADER_ADDRESS);
+    settings_stored_crc = eeprom_read(SETTINGS_HEADER_ADDRESS + 1);
+
+    intact = (MODE_SETTINGS_VERSION == settings_stored_version)
+        && (settings_crc() == settings_stored_crc);
+
+    // Settings stored before there was a header have an erased header. Those
+    // are kept if they are in range, and the header is written for them.
+    blank = (0xFF == settings_stored_version) && (0xFF == settings_stored_crc);
+
+    if (blank)
+    {
+        LOG_INFO("Settings without header, migrating");
+    }
+    else if (!intact)
+    {
+        LOG_WARNING("Settings invalid, loading defaults");
+    }
+
+    for (id = 0; id < MODE_SETTINGS_MAX; id++)
+    {
+        SETTINGS_DIRTY_BYTE(id) &= (unsigned char)~SETTINGS_DIRTY_BIT(id);
+
+        if (SETTING_JOURNALED(id))
+        {
+            // Journaled settings that were never journaled yet start from
+            // their fixed address. The journal checks its own records.
+            if (journal_get(id, &value))
+            {
+                settings_cache[id] = (unsigned char)(value >> 8);
+                settings_cache[id + 1] = (unsigned char)(value & 0xFF);
+            }
+        }
+        else if (blank && !SETTINGS_JOURNALED(id))
+        {
+            // Marked so the next flush writes the header.
+            SETTINGS_DIRTY_BYTE(id) |= SETTINGS_DIRTY_BIT(id);
+        }
+        else if (!intact && !SETTINGS_JOURNALED(id))
+        {
+            settings_cache[id] = settings_registry[id].def;
+            SETTINGS_DIRTY_BYTE(id) |= SETTINGS_DIRTY_BIT(id);
+        }
+
+        if (!settings_valid(id, settings_cache[id]))
+        {
+            settings_cache[id] = settings_registry[id].def;
+            SETTINGS_DIRTY_BYTE(id) |= SETTINGS_DIRTY_BIT(id);
+        }
+    }
+}
+
 unsigned char
 settings_get (unsigned char id)
 {
-    // Right now this function is just a wrapper around reading eeprom.
-    return nvm_eeprom_read(id);
+    if (id < MODE_SETTINGS_MAX)
+    {
+        return settings_cache[id];
+    }
+
+    // Settings nobody reserved are only ever looked at by the settings mode.
+    return eeprom_read(id);
 }
 
 unsigned int
 settings_get_int (unsigned char idh, unsigned char idl)
 {
-    unsigned int ret = (unsigned int)(nvm_eeprom_read(idh) << 8);  // Get MSB of setting
-    ret |= (unsigned int)(nvm_eeprom_read(idl));        // Get LSB of setting
+    unsigned int ret = (unsigned int)(settings_get(idh) << 8);  // Get MSB of setting
+    ret |= (unsigned int)(settings_get(idl));        // Get LSB of setting
     return ret;
 }
 
 void
 settings_set (unsigned char id, unsigned char value)
 {
-    // Right now this function is just a wrapper around writing eeprom.
-    nvm_eeprom_write(id, value);
+    if (id < MODE_SETTINGS_MAX)
+    {
+        // The write is left for settings_flush(). Nothing is written if the
+        // value doesn't change.
+        if ((settings_cache[id] != value) && settings_valid(id, value))
+        {
+            settings_cache[id] = value;
+            SETTINGS_DIRTY_BYTE(id) |= SETTINGS_DIRTY_BIT(id);
+        }
+    }
+    else if (eeprom_read(id) != value)
+    {
+        eeprom_write(id, value);
+    }
 }
 
 void
 settings_set_int (unsigned char idh, unsigned char idl, unsigned int value)
 {
-    nvm_eeprom_write(idh, (unsigned char)(value >> 8));
-    nvm_eeprom_write(idl, (unsigned char)(value & 0xFF));
+    settings_set(idh, (unsigned char)(value >> 8));
+    settings_set(idl, (unsigned char)(value & 0xFF));
+}
+
+void
+settings_flush (void)
+{
+    unsigned char changed = 0;
+    unsigned char crc;
+
+    for (unsigned char id = 0; id < MODE_SETTINGS_MAX; id++)
+    {
+        if (SETTINGS_DIRTY_BYTE(id) & SETTINGS_DIRTY_BIT(id))
+        {
+            SETTINGS_DIRTY_BYTE(id) &= (unsigned char)~SETTINGS_DIRTY_BIT(id);
+
+            if (SETTINGS_JOURNALED(id))
+            {
+                // Both bytes go in one record, the L byte doesn't need its
+                // own once the H byte was written.
+                unsigned char key = SETTINGS_JOURNAL_KEY(id);
+
+                SETTINGS_DIRTY_BYTE(key + 1) &= (unsigned char)~SETTINGS_DIRTY_BIT(key + 1);
+                journal_set(key, (unsigned int)(settings_cache[key] << 8) | settings_cache[key + 1]);
+                continue;
+            }
+
+            changed = 1;
+
+            // A setting changed back to its old value doesn't need a write.
+            // The writes are queued, all of them are done as one batch.
+            if (settings_stored[id] != settings_cache[id])
+            {
+                eeprom_write(id, settings_cache[id]);
+                settings_stored[id] = settings_cache[id];
+            }
+        }
+    }
+
+    if (changed)
+    {
+        // The header goes after the settings, so if we reset in between the
+        // CRC doesn't match and we start over with the defaults.
+        if (MODE_SETTINGS_VERSION != settings_stored_version)
+        {
+            eeprom_write(SETTINGS_HEADER_ADDRESS, MODE_SETTINGS_VERSION);
+            settings_stored_version = MODE_SETTINGS_VERSION;
+        }
+
+        crc = settings_crc();
+        if (crc != settings_stored_crc)
+        {
+            eeprom_write(SETTINGS_HEADER_ADDRESS + 1, crc);
+            settings_stored_crc = crc;
+        }
+    }
+}
+
+
+static unsigned char
+settings_valid (unsigned char id, unsigned char value)
+{
+    if (SETTING_TYPE_SIGNED == settings_registry[id].type)
+    {
+        return ((signed char)settings_registry[id].min <= (signed char)value)
+            && ((signed char)value <= (signed char)settings_registry[id].max);
+    }
+
+    return (settings_registry[id].min <= value)
+        && (value <= settings_registry[id].max);
+}
+
+static unsigned char
+settings_crc (void)
+{
+    unsigned char crc = crc8(CRC8_INIT, MODE_SETTINGS_VERSION);
+
+    for (unsigned char id = 0; id < MODE_SETTINGS_MAX; id++)
+    {
+        if (!SETTINGS_JOURNALED(id))
+        {
+            crc = crc8(crc, settings_cache[id]);
+        }
+    }
+
+    return crc;
 }
 
 
@@ -3,14 +3,52 @@
  * Persistent settings lib for CasiOS.
  * 
  * Settings are 8-bits in length and are stored in EEPROM. There are 256 bytes
- * available in EEPROM, and currently all are available for settings.
- * Settings have an associated ID 0-255. The ID is relative to its place in
- * EEPROM.
+ * available in EEPROM. The top of EEPROM (0xC0-0xFF) is reserved for the
+ * battery history ring (battery.h), 0x80-0xBF for the journal (journal.h) and
+ * 0x40-0x7F for stored alarms (alarm.h). The rest holds the settings and their
+ * header. Settings have an associated ID from 0 to SETTINGS_HEADER_ADDRESS - 1
+ * (0x00-0x3D). The ID is relative to its place in EEPROM, except for settings
+ * that are kept in the journal (see SETTING_JOURNALED() in
+ * modes/mode_settings.h).
+ * 
+ * The settings reserved by modes (modes/mode_settings.h) are loaded into RAM
+ * at boot with one read of their EEPROM, and checked against the CRC and
+ * version stored at SETTINGS_HEADER_ADDRESS. If either doesn't match, every
+ * setting is reset to its default. A header that was never written (erased)
+ * instead keeps every setting that is in range and writes the header. Values
+ * out of range are never stored, so reading them never needs any checks and
+ * never touches EEPROM. Changes are made in RAM and written back by
+ * settings_flush(), which the main loop calls before going to sleep. Only
+ * settings that actually changed are written, through the EEPROM write queue
+ * (eeprom.h).
 */
 
 #ifndef _settings_h_
 #define _settings_h_
 
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * EEPROM address of the settings header, the layout version followed by the
+ * CRC of the settings. Settings reserved by modes have to fit below this.
+*/
+#define SETTINGS_HEADER_ADDRESS     0x3E
+
+////////////////////////////////////////
+
+
+// Types of settings, see MODE_SETTINGS() in modes/mode_settings.h.
+#define SETTING_TYPE_UNSIGNED   0
+#define SETTING_TYPE_SIGNED     1
+
+/**
+ * Load the settings reserved by modes into RAM.
+ * This is called once at boot.
+*/
+void
+settings_load (void);
+
 /**
  * Get setting value.
  * 
@@ -35,6 +73,8 @@ settings_get_int (unsigned char idh, unsigned char idl);
 /**
  * Set setting value.
  * 
+ * Values out of the range of a setting are ignored.
+ * 
  * @param[in]   id      Setting ID.
  * @param[in]   value   Value to set.
 */
@@ -51,6 +91,13 @@ settings_set(unsigned char id, unsigned char value);
 void
 settings_set_int (unsigned char idh, unsigned char idl, unsigned int value);
 
+/**
+ * Write changed settings back to EEPROM.
+ * This is called by the main loop when there is nothing else to do.
+*/
+void
+settings_flush (void);
+
 
 #endif
 
@@ -0,0 +1,210 @@
+/** @file timeout.c
+ * Timeout library for CasiOS.
+*/
+
+#include <xc.h>
+
+#include "drivers/timers.h"
+
+#include "lib/isr.h"
+
+#include "lib/timeout.h"
+
+#define LOG_TAG "lib.timeout"
+#include "lib/logging.h"
+
+
+/** A pending timeout. Free slots have no callback. */
+typedef struct
+{
+    timeout_callback_t callback;
+    unsigned char ticks;            /**< Ticks left until the callback. */
+} timeout_t;
+
+/** Pending timeouts. */
+static volatile timeout_t timeouts[TIMEOUT_SLOTS];
+
+static void timeout_isr (void);
+
+/**
+ * Stop the timer and subtract the time it counted from every pending timeout.
+ * Timeouts that should have expired are left with 0 ticks.
+*/
+static void timeout_advance (void);
+
+/**
+ * Start the timer for the next timeout to expire.
+ * The timer stays stopped if nothing is pending.
+*/
+static void timeout_schedule (void);
+
+
+void
+timeout_init (void)
+{
+    LOG_INFO("Initializing timeouts...");
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        timeouts[slot].callback = 0;
+    }
+
+    timer2_init();
+
+    // Register ISR
+    isr_register(4, _PIR4_TMR2IF_MASK, &timeout_isr);
+}
+
+void
+timeout_set (timeout_callback_t callback, unsigned char ticks)
+{
+    signed char free_slot = -1;
+
+    // Keep every ISR out while the slots change, not only ours. Timeouts are
+    // also set from other interrupts (keypad), which would otherwise take the
+    // slot we found or restart the timer halfway through. We might be called
+    // from an ISR, so interrupts are only reenabled if they were enabled to
+    // begin with.
+    unsigned char gie = INTCONbits.GIE;
+    di();
+    timer2_interrupt_disable();
+
+    timeout_advance();
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        if (callback == timeouts[slot].callback)
+        {
+            // Restart the pending timeout.
+            free_slot = (signed char)slot;
+            break;
+        }
+
+        if ((0 == timeouts[slot].callback) && (0 > free_slot))
+        {
+            free_slot = (signed char)slot;
+        }
+    }
+
+    if (0 > free_slot)
+    {
+        LOG_ERROR("No free timeout slots!");
+    }
+    else
+    {
+        timeouts[free_slot].callback = callback;
+        timeouts[free_slot].ticks = ticks;
+    }
+
+    timeout_schedule();
+
+    INTCONbits.GIE = gie;
+}
+
+void
+timeout_cancel (timeout_callback_t callback)
+{
+    // Same as timeout_set(), keep every ISR out.
+    unsigned char gie = INTCONbits.GIE;
+    di();
+    timer2_interrupt_disable();
+
+    timeout_advance();
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        if (callback == timeouts[slot].callback)
+        {
+            timeouts[slot].callback = 0;
+        }
+    }
+
+    timeout_schedule();
+
+    INTCONbits.GIE = gie;
+}
+
+
+static void
+timeout_isr (void)
+{
+    timeout_callback_t callback;
+
+    timeout_advance();
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        if (timeouts[slot].callback && (0 == timeouts[slot].ticks))
+        {
+            // Free the slot first so the callback can set itself again.
+            callback = timeouts[slot].callback;
+            timeouts[slot].callback = 0;
+
+            callback();
+        }
+    }
+
+    timeout_schedule();
+}
+
+static void
+timeout_advance (void)
+{
+    unsigned int elapsed;
+
+    timer2_stop();
+
+    elapsed = timer2_get();
+    timer2_set(0);
+
+    // The timer rolled over at the period, which was the next timeout.
+    if (timer2_interrupt_flag())
+    {
+        elapsed += timer2_period_get() + 1;
+        timer2_interrupt_clear();
+    }
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        if (timeouts[slot].ticks > elapsed)
+        {
+            timeouts[slot].ticks -= (unsigned char)elapsed;
+        }
+        else
+        {
+            timeouts[slot].ticks = 0;
+        }
+    }
+}
+
+static void
+timeout_schedule (void)
+{
+    unsigned char next = 0;
+
+    for (unsigned char slot = 0; slot < TIMEOUT_SLOTS; slot++)
+    {
+        if (timeouts[slot].callback)
+        {
+            if (0 == timeouts[slot].ticks)
+            {
+                // Expired but not called yet, go as soon as possible.
+                timeouts[slot].ticks = 1;
+            }
+
+            if ((0 == next) || (timeouts[slot].ticks < next))
+            {
+                next = timeouts[slot].ticks;
+            }
+        }
+    }
+
+    if (next)
+    {
+        timer2_period_set(next - 1);
+        timer2_interrupt_enable();
+        timer2_start();
+    }
+}
+
+// EOF //
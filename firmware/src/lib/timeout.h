@@ -0,0 +1,81 @@
+/** @file timeout.h
+ * Timeout library for CasiOS.
+ *
+ * Calls a function once after a delay. This is meant for libraries that need
+ * to do something a short time from now without waking up the mode
+ * application, e.g. blinking part of the display.
+ *
+ * All timeouts share timer2, which counts the 32kHz clock with a 1:128
+ * prescaler so it keeps running while we sleep. The timer is only running
+ * while a timeout is pending, and only interrupts when the next one expires.
+ *
+ * Callbacks are called from the interrupt, so they should be short. A callback
+ * may set itself again to repeat. Timeouts can be set and cancelled from the
+ * main loop and from any interrupt, interrupts are held off while the slots
+ * change.
+*/
+
+#ifndef _timeout_h_
+#define _timeout_h_
+
+////////////////////////////////////////
+// Lib Config //
+
+/**
+ * Number of timeouts that can be pending at the same time.
+*/
+#define TIMEOUT_SLOTS       6
+
+////////////////////////////////////////
+
+
+/**
+ * Frequency of timeout ticks in Hz.
+ * Rev 1 of the PCB clocks the timer from the ~31kHz LFINTOSC instead of the
+ * 32.768kHz xtal.
+*/
+#if (1 == PCB_REV)
+#   define TIMEOUT_HZ       242
+#else
+#   define TIMEOUT_HZ       256
+#endif
+
+/**
+ * Convert milliseconds to timeout ticks.
+ * This is meant for constants, so the conversion is done at compile time.
+ * The longest timeout is 255 ticks, just short of a second.
+*/
+#define TIMEOUT_MS(ms)      ((unsigned char)(((unsigned long)(ms) * TIMEOUT_HZ) / 1000))
+
+/**
+ * Timeout callback function.
+*/
+typedef void (*timeout_callback_t)(void);
+
+/**
+ * Initialize the timeout library.
+*/
+void
+timeout_init (void);
+
+/**
+ * Call a function after a delay.
+ * If the callback already has a timeout pending, it is restarted with the new
+ * delay.
+ *
+ * @param[in]   callback    Function to call when the timeout expires.
+ * @param[in]   ticks       Delay in timeout ticks, see TIMEOUT_MS().
+*/
+void
+timeout_set (timeout_callback_t callback, unsigned char ticks);
+
+/**
+ * Cancel the pending timeout of a callback.
+ * Nothing happens if the callback has no timeout pending.
+*/
+void
+timeout_cancel (timeout_callback_t callback);
+
+#endif
+
+// EOF //
@@ -15,6 +15,7 @@
 #include "lib/mode.h"
 #include "lib/events.h"
 #include "lib/tick.h"
+#include "lib/timeout.h"
 #include "lib/datetime.h"
 #include "lib/alarm.h"
 #include "lib/buttons.h"
@@ -22,7 +23,10 @@
 #include "lib/backlight.h"
 #include "lib/buzzer.h"
 #include "lib/display.h"
+#include "lib/eeprom.h"
 #include "lib/battery.h"
+#include "lib/journal.h"
+#include "lib/settings.h"
 
 #define LOG_TAG "main"
 #include "lib/logging.h"
@@ -46,6 +50,7 @@ setup (void)
 
     // Initialize peripheral libraries:
     // - Timers     (tick.h)
+    //   - Timeouts (timeout.h)
     // - RTCC       (datetime.h)
     //   - Alarm    (alarm.h)
     // - LCD        (display.h)
@@ -53,9 +58,13 @@ setup (void)
     // - Buttons    (buttons.h)
     // - Buzzer     (buzzer.h)
     // - Backlight  (backlight.h)
+    // - EEPROM     (eeprom.h)
     // - ADC        (battery.h)
+    // - Journal    (journal.h)
+    // - Settings   (settings.h)
     //
     tick_init();
+    timeout_init();
     datetime_init();
     alarm_init();
     display_init();
@@ -63,7 +72,10 @@ setup (void)
     buttons_init();
     buzzer_init();
     backlight_init();
+    eeprom_init();
     battery_init();
+    journal_init();
+    settings_load();
 }
 
 /**
@@ -97,11 +109,17 @@ main (void)
             // If we have an event in the queue, we call the mode thread to
             // handle it.
             mode_thread();
-            
-            // Update the display after running the mode.
-            display_update();
         }
 
+        // Update the display after running the mode. This is done for every
+        // wake up, as the display can also change on its own (scrolling).
+        display_update();
+
+        // Write back any settings that were changed while we have nothing
+        // else to do.
+        settings_flush();
+        alarm_flush();
+
         // If logs are not disabled, wait for the transmit buffer to empty
         // before going to sleep.
 #       if LOG_LVL
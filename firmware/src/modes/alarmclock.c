@@ -9,6 +9,7 @@
 #include "lib/mode.h"
 #include "lib/events.h"
 #include "lib/tick.h"
+#include "lib/timeout.h"
 #include "lib/alarm.h"
 #include "lib/display.h"
 #include "lib/keypad.h"
@@ -35,16 +36,80 @@ static unsigned char hourly_alarm_enabled = 0;
 // Time object to hold the next hourly alarm.
 static time_t hourly_alarm;
 
+// Blink rate of the position being edited
+#define ALARMCLOCK_BLINK    TIMEOUT_MS(500)
+
+// Seconds the daily alarm rings for if it isn't silenced
+#define ALARMCLOCK_RING_SECONDS     30
+
+// A 75ms alarm beep at a volume, followed by a gap
+#define ALARMCLOCK_BEEP(volume, gap_ms)     BUZZER_NOTE(3200, volume, 75, gap_ms)
+
+// The daily alarm starts quiet and every 2 seconds gets louder and beeps more
+// often.
+static const buzzer_note_t daily_alarm_ramp[] = {
+    ALARMCLOCK_BEEP(10, 925),
+    ALARMCLOCK_BEEP(10, 925),
+    ALARMCLOCK_BEEP(30, 50), ALARMCLOCK_BEEP(30, 800),
+    ALARMCLOCK_BEEP(30, 50), ALARMCLOCK_BEEP(30, 800),
+    ALARMCLOCK_BEEP(60, 50), ALARMCLOCK_BEEP(60, 50),
+    ALARMCLOCK_BEEP(60, 50), ALARMCLOCK_BEEP(60, 550),
+    ALARMCLOCK_BEEP(60, 50), ALARMCLOCK_BEEP(60, 50),
+    ALARMCLOCK_BEEP(60, 50), ALARMCLOCK_BEEP(60, 550),
+};
+#define DAILY_ALARM_RAMP_SECONDS    6
+
+// Once at full volume, this second repeats until the alarm is done.
+static const buzzer_note_t daily_alarm_loud[] = {
+    ALARMCLOCK_BEEP(100, 50), ALARMCLOCK_BEEP(100, 50),
+    ALARMCLOCK_BEEP(100, 50), ALARMCLOCK_BEEP(100, 550),
+};
+
+// Beep Pause Beep
+static const buzzer_note_t hourly_alarm_chime[] = {
+    BUZZER_NOTE(4500, 100, 75, 100),
+    BUZZER_NOTE(4500, 100, 75, 0),
+};
+
 // Draw the daily alarm time to the display.
 void daily_alarm_draw (void);
 void daily_alarm_edit_draw (void);
 void alarmclock_edit_start (void);
+static void alarmclock_edit_blink (void);
 void hourly_alarm_update (void);
 
 void
 alarmclock_init (void)
 {
-    // Initialize some default values for the hourly alarm
+    datetime_t alarm_datetime;
+
+    // Restore the daily alarm if it was registered before a reset. If it
+    // went off while we were reset, it's registered again for tomorrow.
+    if (alarm_find_event(ALARMCLOCK_EVENT_DAILY, &alarm_datetime))
+    {
+        daily_alarm = alarm_datetime.time;
+        daily_alarm_enabled = 1;
+    }
+    else if (alarm_missed(ALARMCLOCK_EVENT_DAILY, &alarm_datetime))
+    {
+        LOG_INFO("Missed daily alarm");
+        daily_alarm = alarm_datetime.time;
+        daily_alarm_enabled = 1;
+        alarm_set_time(&daily_alarm, ALARMCLOCK_EVENT_DAILY);
+    }
+
+    // Same for the hourly chime, which is always on the hour.
+    if (alarm_find_event(ALARMCLOCK_EVENT_CHIME, &alarm_datetime))
+    {
+        hourly_alarm = alarm_datetime.time;
+        hourly_alarm_enabled = 1;
+    }
+    else if (alarm_missed(ALARMCLOCK_EVENT_CHIME, &alarm_datetime))
+    {
+        hourly_alarm_enabled = 1;
+        hourly_alarm_update();
+        alarm_set_time(&hourly_alarm, ALARMCLOCK_EVENT_CHIME);
+    }
 }
 
 void
@@ -141,9 +206,6 @@ alarmclock_run (unsigned int event)
             // Set the run thread to be our edit thread
             alarmclock_mode.run = &alarmclock_edit;
 
-            // Set tickrate to our blink rate
-            tick_rate_set_ms(500);
-
             alarmclock_edit_start();
         }
     }
@@ -164,6 +226,12 @@ alarmclock_stop (void)
 
 static unsigned char daily_alarm_is_beeping = 0;
 
+// Buzzer sequence of the daily alarm that is playing.
+static unsigned char daily_alarm_sequence = 0;
+
+// Seconds the daily alarm has been ringing.
+static unsigned char daily_alarm_ring_seconds = 0;
+
 void
 alarmclockd (unsigned int event)
 {
@@ -172,10 +240,11 @@ alarmclockd (unsigned int event)
         if (EVENT_DATA(event) == ALARMCLOCK_EVENT_CHIME)
         {
             LOG_DEBUG("Chime alarm event event");
-            // Beep Block Beep
-            buzzer_tone(4500, 100, 75);
-            __delay_ms(100);
-            buzzer_tone(4500, 100, 75);
+            if (!daily_alarm_is_beeping)
+            {
+                buzzer_play(hourly_alarm_chime,
+                    sizeof(hourly_alarm_chime) / sizeof(hourly_alarm_chime[0]));
+            }
 
             // Update hourly alarm to new time
             hourly_alarm_update();
@@ -187,18 +256,12 @@ alarmclockd (unsigned int event)
         if (EVENT_DATA(event) == ALARMCLOCK_EVENT_DAILY)
         {
             LOG_DEBUG("Daily alarm event");
-            // 20 sec long alarm
+            // Rings in the background for ALARMCLOCK_RING_SECONDS.
             // Disabled with any button press
-
-            // NOTE: Since our buzzer and delays block right now, we just give
-            // a few beeps. (This means you can't silence it)
-            // daily_alarm_is_beeping = 1;
-            buzzer_tone(3200, 100, 75);
-            __delay_ms(50);
-            buzzer_tone(3200, 100, 75);
-            __delay_ms(50);
-            buzzer_tone(3200, 100, 75);
-
+            daily_alarm_is_beeping = 1;
+            daily_alarm_ring_seconds = DAILY_ALARM_RAMP_SECONDS;
+            daily_alarm_sequence = buzzer_play(daily_alarm_ramp,
+                sizeof(daily_alarm_ramp) / sizeof(daily_alarm_ramp[0]));
 
             // Set another alarm for our daily time, this should be
             // automatically set for tomorrow since the time has passed.
@@ -206,19 +269,41 @@ alarmclockd (unsigned int event)
         }
     }
 
+    if (daily_alarm_is_beeping && (EVENT_TYPE(event) == EVENT_BUZZER))
+    {
+        if (EVENT_DATA(event) != daily_alarm_sequence)
+        {
+            // Another sound took over the buzzer and stopped the alarm. Its
+            // end is not ours to ring on from.
+            LOG_DEBUG("Daily alarm interrupted");
+            daily_alarm_is_beeping = 0;
+        }
+        else if (daily_alarm_ring_seconds < ALARMCLOCK_RING_SECONDS)
+        {
+            // Keep ringing at full volume.
+            daily_alarm_ring_seconds++;
+            daily_alarm_sequence = buzzer_play(daily_alarm_loud,
+                sizeof(daily_alarm_loud) / sizeof(daily_alarm_loud[0]));
+        }
+        else
+        {
+            LOG_DEBUG("Daily alarm done");
+            daily_alarm_is_beeping = 0;
+        }
+    }
+
     if (daily_alarm_is_beeping &&
-        ((EVENT_TYPE(event) == EVENT_KEYPAD) || 
+        (((EVENT_TYPE(event) & 0x0F) == EVENT_KEYPAD) ||
         (EVENT_TYPE(event) == EVENT_BUTTON)))
     {
         // Daily alarm is beeping, any button or keypress silences it.
         LOG_DEBUG("Silencing daily alarm");
         daily_alarm_is_beeping = 0;
+        buzzer_stop();
     }
 }
 
 
-static unsigned char edit_blink = 0;
-
 static unsigned char edit_position = 0;
 
 static unsigned char edit_tod = 0;
@@ -226,7 +311,6 @@ static unsigned char edit_tod = 0;
 void
 alarmclock_edit_start (void)
 {
-    edit_blink = 1;
     edit_position = 1;
 
     // We temporarily convert the time to 12 hour format
@@ -256,36 +340,19 @@ alarmclock_edit_start (void)
 
     // And clear the alarm enabled wave
     display_misc_clear(DISPLAY_MISC_WAVE);
+
+    // Draw our alarm time
+    daily_alarm_edit_draw();
+
+    // Blink character that is currently being edited and the am/pm sign
+    display_misc_blink(DISPLAY_MISC_AM, ALARMCLOCK_BLINK);
+    display_misc_blink(DISPLAY_MISC_PM, ALARMCLOCK_BLINK);
+    alarmclock_edit_blink();
 }
 
 signed char
 alarmclock_edit (unsigned int event)
 {
-    if (EVENT_TYPE(event) == EVENT_TICK)
-    {
-        // Draw our alarm time
-        daily_alarm_edit_draw();
-
-        // Blink character that is currently being edited
-        // and am/pm sign
-        if (edit_blink)
-        {
-            // We are blinking meaning we are drawing an underscore in place 
-            // of the current place being edited
-            display_primary_character((signed char)edit_position, '_');
-
-            // And clearing the AM/PM
-            display_misc_clear(DISPLAY_MISC_AM);
-            display_misc_clear(DISPLAY_MISC_PM);
-
-            edit_blink = 0;
-        }
-        else
-        {
-            edit_blink = 1;
-        }
-    }
-
     if (EVENT_TYPE(event) == EVENT_KEYPAD)
     {
         unsigned char keypress = EVENT_DATA(event);
@@ -361,6 +428,7 @@ alarmclock_edit (unsigned int event)
             }
 
             daily_alarm_edit_draw();
+            alarmclock_edit_blink();
         }
 
         if (keypress == '.')
@@ -405,6 +473,8 @@ alarmclock_edit (unsigned int event)
                     edit_position = 1;
                 break;
             }
+
+            alarmclock_edit_blink();
         }
         if (EVENT_DATA(event) == BUTTON_ADJ_PRESS)
         {
@@ -448,8 +518,8 @@ alarmclock_edit (unsigned int event)
             // Set the run thread to be our main run thread
             alarmclock_mode.run = &alarmclock_run;
 
-            // Disable ticks
-            tick_disable();
+            // Stop blinking
+            display_blink_clear();
 
             // There might be a 0 in the hour tens place if hour < 10
             display_primary_clear(1);
@@ -460,6 +530,16 @@ alarmclock_edit (unsigned int event)
 }
 
 
+/**
+ * Blink the character at the current edit position.
+*/
+static void
+alarmclock_edit_blink (void)
+{
+    display_primary_blink(0, 0);
+    display_primary_blink((signed char)edit_position, ALARMCLOCK_BLINK);
+}
+
 void
 hourly_alarm_update (void)
 {
@@ -540,23 +620,20 @@ daily_alarm_draw (void)
     display_period(DISPLAY_PERIOD_COLON);
 
     // (4-5) Display minute
-    display_primary_character(4, (daily_alarm.minute >> 4));
-    display_primary_character(5, (daily_alarm.minute & 0x0F));
+    display_primary_bcd(5, daily_alarm.minute, 2);
 }
 
 void
 daily_alarm_edit_draw (void)
 {
     // (Pos 1-2) Display hour
-    display_primary_character(1, (daily_alarm.hour >> 4));
-    display_primary_character(2, (daily_alarm.hour & 0x0F));
+    display_primary_bcd(2, daily_alarm.hour, 2);
 
     // (3) Display colon
     display_period(DISPLAY_PERIOD_COLON);
 
     // (4-5) Display minute
-    display_primary_character(4, (daily_alarm.minute >> 4));
-    display_primary_character(5, (daily_alarm.minute & 0x0F));
+    display_primary_bcd(5, daily_alarm.minute, 2);
 
     if (edit_tod)
     {
@@ -8,6 +8,7 @@
 #include "lib/mode.h"
 #include "lib/events.h"
 #include "lib/tick.h"
+#include "lib/timeout.h"
 #include "lib/display.h"
 #include "lib/buttons.h"
 #include "lib/keypad.h"
@@ -32,6 +33,10 @@ void clock_draw_weekday (unsigned char weekday);
 // Edit helper functions
 static void clock_draw_edit (void);
 static void clock_edit_next (void);
+static void clock_edit_blink (void);
+
+// Blink rate of the position being edited
+#define CLOCK_BLINK     TIMEOUT_MS(500)
 
 // Needed variables
 static volatile unsigned char clock_fmt = 0; // 24/12 HR time format flag
@@ -52,19 +57,9 @@ clock_init (void)
 void
 clock_start (void)
 {
-    // Load clock_fmt from settings
+    // Load clock_fmt from settings, it's always in range 0-1.
     clock_fmt = settings_get(SETTING_CLOCK_FMT);
 
-    // Verify value is in range 0-1
-    if (1 < clock_fmt)
-    {
-        // We default to 24-hour time with unknown values.
-        clock_fmt = 0;
-
-        // And reset setting value to 0
-        settings_set(SETTING_CLOCK_FMT, 0);
-    }
-
     // Get current time
     datetime_now(&now);
 
@@ -199,7 +194,6 @@ clock_stop (void)
 
 
 static datetime_t edit_now;
-static unsigned char edit_blink = 0;
 static unsigned char edit_position = 0;
 
 //
@@ -241,23 +235,24 @@ enum {
 void
 clock_edit_start (void)
 {
-    // Blink off the bat
-    edit_blink = 1;
-
     // Always start editing the time seconds place
     edit_position = POS_SECONDS;
 
     // Get the current time
     datetime_now(&edit_now);
 
-    // Set our edit tickrate to 1/2 a sec for blinking the current character.
-    tick_rate_set_ms(500);
+    // Tick every second to keep the seconds running while editing the time.
+    // Blinking the current character is done by the display.
+    tick_rate_set_sec(1);
 
     // Draw time
     clock_draw_edit();
     
     // Clear seconday display of weekday
     display_secondary_clear(0);
+
+    // Blink the seconds
+    clock_edit_blink();
 }
 
 /**
@@ -268,52 +263,11 @@ clock_edit (unsigned int event)
 {
     if (EVENT_TYPE(event) == EVENT_TICK)
     {
-        if (edit_blink)
-        {
-            // We are currently blinking the selected character position.
-
-            if (edit_position == POS_WEEKDAY)
-            {
-                // When we are editing the weekday, flash the numerical value
-                display_secondary_clear(0);
-                display_secondary_character(1, (edit_now.date.weekday >> 4));
-                display_secondary_character(2, (edit_now.date.weekday & 0x0F));
-            }
-            else if (edit_position > POS_DATE)
-            {
-                // We need to subtract POS_DATE from the edit position to get
-                // the actual display character position.
-                display_primary_character((signed char)
-                    (edit_position - POS_DATE), 
-                    '_'
-                );
-            }
-            else
-            {
-                // If we are editing time the positions work out correctly.
-                display_primary_character((signed char)edit_position, '_');
-
-                if (POS_SECONDS == edit_position)
-                {
-                    // Blink both second characters
-                    display_primary_character(POS_SECONDS_ONES, '_');
-                }
-            }
+        // Update seconds
+        edit_now.time.second = SECONDS;
 
-            // Update display next tick
-            edit_blink = 0;
-        }
-        else
-        {
-            // Update seconds
-            edit_now.time.second = SECONDS;
-
-            // Draw edited time or date
-            clock_draw_edit();
-
-            // Blink next tick
-            edit_blink = 1;
-        }
+        // Draw edited time or date
+        clock_draw_edit();
     }
 
     if (EVENT_TYPE(event) == EVENT_KEYPAD)
@@ -410,6 +364,9 @@ clock_edit (unsigned int event)
         {
             // Press of the mode button advances the edit position
             clock_edit_next();
+
+            // Draw the time or date the position is on
+            clock_draw_edit();
         }
 
         if (EVENT_DATA(event) == BUTTON_ADJ_PRESS)
@@ -431,6 +388,9 @@ clock_edit (unsigned int event)
                 settings_set(SETTING_CLOCK_FMT, clock_fmt);
             }
 
+            // Stop blinking
+            display_blink_clear();
+
             // Set main run thread function
             clock_mode.run = &clock_run;
 
@@ -454,15 +414,13 @@ void
 clock_draw_time (time_t *draw_time)
 {
     // Draw second
-    display_primary_character(8, (draw_time->second & 0x0F));
-    display_primary_character(7, (draw_time->second >> 4));
+    display_primary_bcd(8, draw_time->second, 2);
 
     // Clear space between minutes and seconds
     display_primary_clear(6);
 
     // Draw minute
-    display_primary_character(5, (draw_time->minute & 0x0F));
-    display_primary_character(4, (draw_time->minute >> 4));
+    display_primary_bcd(5, draw_time->minute, 2);
 
     // Colon
     display_period(DISPLAY_PERIOD_COLON);
@@ -533,8 +491,7 @@ clock_draw_time (time_t *draw_time)
     else
     {
         // 24-hour format
-        display_primary_character(2, (draw_time->hour & 0x0F));
-        display_primary_character(1, (draw_time->hour >> 4));
+        display_primary_bcd(2, draw_time->hour, 2);
 
         // Clear AM/PM
         display_misc_clear(DISPLAY_MISC_AM);
@@ -550,8 +507,7 @@ void
 clock_draw_date (date_t *draw_date)
 {
     // Draw year (20XX)
-    display_primary_character(1, (draw_date->year >> 4));
-    display_primary_character(2, (draw_date->year & 0x0F));
+    display_primary_bcd(2, draw_date->year, 2);
 
     // Clear space between year and month
     display_primary_clear(3);
@@ -559,15 +515,13 @@ clock_draw_date (date_t *draw_date)
     display_period_clear(DISPLAY_PERIOD_COLON);
 
     // Draw month
-    display_primary_character(4, (draw_date->month >> 4));
-    display_primary_character(5, (draw_date->month & 0x0F));
+    display_primary_bcd(5, draw_date->month, 2);
 
     // Draw dash between month and day
     display_primary_character(6, '-');
 
     // Draw day
-    display_primary_character(7, (draw_date->day >> 4));
-    display_primary_character(8, (draw_date->day & 0x0F));
+    display_primary_bcd(8, draw_date->day, 2);
 
     // Draw weekday
     clock_draw_weekday(draw_date->weekday);
@@ -641,7 +595,13 @@ clock_draw_weekday (unsigned char weekday)
 static void
 clock_draw_edit (void)
 {
-    if (edit_position > POS_DATE)
+    if (edit_position == POS_WEEKDAY)
+    {
+        // When we are editing the weekday, show the numerical value
+        clock_draw_date(&edit_now.date);
+        display_secondary_bcd(2, edit_now.date.weekday, 2);
+    }
+    else if (edit_position > POS_DATE)
     {
         // We're editing the date.
         clock_draw_date(&edit_now.date);
@@ -684,6 +644,9 @@ clock_edit_next (void)
         // Start editing the date after the minute
         case POS_MIN_ONES:
             edit_position = POS_YEAR_TENS;
+
+            // The date doesn't change, so we don't need ticks to redraw it.
+            tick_disable();
         break;
 
         // Skip to seconds after the weekday
@@ -693,6 +656,9 @@ clock_edit_next (void)
             // Clear weekday
             // TODO: This isnt really a good spot for this, but it works.
             display_secondary_clear(0);
+
+            // Tick again to keep the seconds running.
+            tick_rate_set_sec(1);
         break;
 
         // Seconds is the last position and wraps back to the hour
@@ -700,6 +666,40 @@ clock_edit_next (void)
             edit_position = POS_HOUR_TENS;
         break;
     }
+
+    clock_edit_blink();
+}
+
+/**
+ * Blink the character(s) at the current edit position.
+*/
+static void
+clock_edit_blink (void)
+{
+    display_blink_clear();
+
+    if (edit_position == POS_WEEKDAY)
+    {
+        // The weekday is edited on the secondary display.
+        display_secondary_blink(0, CLOCK_BLINK);
+    }
+    else if (edit_position > POS_DATE)
+    {
+        // We need to subtract POS_DATE from the edit position to get
+        // the actual display character position.
+        display_primary_blink((signed char)(edit_position - POS_DATE), CLOCK_BLINK);
+    }
+    else
+    {
+        // If we are editing time the positions work out correctly.
+        display_primary_blink((signed char)edit_position, CLOCK_BLINK);
+
+        if (POS_SECONDS == edit_position)
+        {
+            // Blink both second characters
+            display_primary_blink(POS_SECONDS_ONES, CLOCK_BLINK);
+        }
+    }
 }
 
 
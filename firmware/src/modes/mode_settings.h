@@ -2,28 +2,65 @@
  * 
  * Global settings defined by modes.
  * 
- * To reserve a setting ID for a mode, add it to the enum contained in this
+ * To reserve a setting ID for a mode, add it to MODE_SETTINGS() in this
  * header. This will allow other modes to reference this setting, however
  * other modes may also change the value.
+ * 
+ * Every setting has a type, a default value and a range of valid values. The
+ * settings lib (lib/settings.h) only ever stores values in range, so modes
+ * don't have to check them. If the stored settings don't match their CRC or
+ * MODE_SETTINGS_VERSION, all of them are reset to their defaults. Bump the
+ * version when the meaning of an existing ID changes.
+ * 
+ * 16-bit settings that change often should be added to SETTING_JOURNALED().
+ * These are kept in the journal (lib/journal.h) instead of a fixed EEPROM
+ * address, which spreads the writes across more of the EEPROM. Both bytes are
+ * kept in one record, so they are always updated together.
 */
 
 #ifndef _mode_settings_h_
 #define _mode_settings_h_
 
+/** Version of the settings layout. */
+#define MODE_SETTINGS_VERSION   1
+
+/**
+ * Every setting as SETTING(id, type, default, min, max).
+ * Types are SETTING_TYPE_UNSIGNED or SETTING_TYPE_SIGNED.
+*/
+#define MODE_SETTINGS(SETTING)                                              \
+    /* 0/1 for 24/12 hour clock format */                                   \
+    SETTING(SETTING_CLOCK_FMT,      SETTING_TYPE_UNSIGNED,  0,  0,      1)  \
+                                                                            \
+    /* RTCCAL value */                                                      \
+    SETTING(SETTING_RTC_OFFSET,     SETTING_TYPE_SIGNED,    0,  -128, 127)  \
+                                                                            \
+    /* Temperature calibration reading at 25C */                            \
+    /* 12-bit value stored as 2 bytes H:L */                                \
+    SETTING(SETTING_TEMP_CAL_1H,    SETTING_TYPE_UNSIGNED,  0,  0,   0x0F)  \
+    SETTING(SETTING_TEMP_CAL_1L,    SETTING_TYPE_UNSIGNED,  0,  0,   0xFF)  \
+                                                                            \
+    /* Uptime value stored as days */                                       \
+    /* 16-bit stored as 2 bytes H:L */                                      \
+    SETTING(SETTING_UPTIME_H,       SETTING_TYPE_UNSIGNED,  0,  0,   0xFF)  \
+    SETTING(SETTING_UPTIME_L,       SETTING_TYPE_UNSIGNED,  0,  0,   0xFF)
+
+#define SETTING_ENUM(id, type, def, min, max)   id,
+
 enum global_settings_mode {
-    SETTING_CLOCK_FMT,      // 0/1 for 24/12 hour clock format
-    
-    SETTING_RTC_OFFSET,     // RTCCAL value
-    
-    SETTING_TEMP_CAL_1H,    // Temperature calibration reading at 25C
-    SETTING_TEMP_CAL_1L,    // 12-bit value stored as 2 bytes H:L
-    
-    SETTING_UPTIME_H,       // Uptime value stored as days
-    SETTING_UPTIME_L,       // 16-bit stored as 2 bytes H:L
+    MODE_SETTINGS(SETTING_ENUM)
 
     MODE_SETTINGS_MAX
 };
 
+/**
+ * Check if a setting is kept in the journal.
+ * Journaled settings are stored as 2 bytes H:L with the L byte at the next ID,
+ * only the ID of the H byte is listed here.
+*/
+#define SETTING_JOURNALED(id)   \
+    (SETTING_UPTIME_H == (id))
+
 #endif
 
 // EOF //
@@ -5,6 +5,14 @@
  * when pressed (/)[TODO].
  * 
  * Voltage displayed seems to be within -+0.02V of actual voltage.
+ * 
+ * A battery reading is recorded to the battery history once a day at noon.
+ * The (=) key cycles through summaries of the history:
+ *  1. Live         The current battery voltage.
+ *  2. History      The oldest and newest recorded voltages, and the number of
+ *                  days recorded in the secondary display.
+ *  3. Estimate     Estimated days until the battery reaches POWER_CUTOFF_MV,
+ *                  based on the average daily drop over the history.
 */
 
 #include <xc.h>
@@ -18,7 +26,9 @@
 #include "lib/buttons.h"
 #include "lib/keypad.h"
 #include "lib/backlight.h"
-// #include "lib/buzzer.h"
+#include "lib/datetime.h"
+#include "lib/alarm.h"
+#include "lib/buzzer.h"
 
 #include "lib/logging.h"
 
@@ -30,12 +40,55 @@
 #undef  LOG_TAG
 #define LOG_TAG "mode.power"
 
+/** Voltage at which we consider the battery to need replacing. */
+#define POWER_CUTOFF_MV     2200
+
+/** Views that can be selected with the (=) key. */
+enum power_views {
+    POWER_VIEW_LIVE,
+    POWER_VIEW_HISTORY,
+    POWER_VIEW_ESTIMATE,
+    POWER_VIEW_MAX
+};
+
 // This variable holds the battery voltage as a float.
 static float battery_voltage = 0.0;
 
+// Currently shown view.
+static unsigned char power_view = POWER_VIEW_LIVE;
+
+// Tone that loads the battery while watching the voltage.
+static const buzzer_note_t power_load_tone[] = {
+    BUZZER_NOTE(3000, 100, 5000, 0),
+};
+
+// Time repr of 12:00 noon, when the daily battery reading is recorded.
+static time_t noon = {0x12, 0x00, 0x00};
+
+// Draw the selected view.
+static void power_view_draw (void);
+
+// Estimate the days left until the battery reaches the cutoff voltage.
+static signed long power_days_left (void);
+
+void
+power_init (void)
+{
+    datetime_t alarm_datetime;
+
+    // Register alarm for the daily battery reading, unless it was restored
+    // after a reset.
+    if (!alarm_find_event(POWER_ALARM_EVENT, &alarm_datetime))
+    {
+        alarm_set_time(&noon, POWER_ALARM_EVENT);
+    }
+}
+
 void
 power_start (void)
 {
+    power_view = POWER_VIEW_LIVE;
+
     // Draw something immediately.
     display_secondary_string(1, "bA");
     display_primary_string(1, "bat ---V");
@@ -65,13 +118,23 @@ switch (EVENT_TYPE(event))
         // the previous value.
         battery_voltage += battery_read_voltage();
         battery_voltage /= 2;
-        display_primary_number(7, lroundf(battery_voltage*100));
+
+        if (POWER_VIEW_LIVE == power_view)
+        {
+            display_primary_number(7, lroundf(battery_voltage*100));
+        }
 
         LOG_INFO("Battery: %0.2f", battery_voltage);
     break;
 
     case KEYPAD_EVENT_PRESS:
-        if (EVENT_DATA(event) == '/')
+        if (EVENT_DATA(event) == '=')
+        {
+            // Equals key cycles through the history views.
+            power_view = (power_view + 1) % POWER_VIEW_MAX;
+            power_view_draw();
+        }
+        else if (EVENT_DATA(event) == '/')
         {
             // Divide key turns on backlight.
             backlight_on();
@@ -81,12 +144,13 @@ switch (EVENT_TYPE(event))
 
             // Get initial voltage with the backlight on.
             battery_voltage = battery_read_voltage();
-            display_primary_number(7, lroundf(battery_voltage*100));
+            power_view = POWER_VIEW_LIVE;
+            power_view_draw();
         }
         else if (EVENT_DATA(event) == '+')
         {
             // Plus key plays a 5 sec tone.
-            // buzzer_tone2(3000, 100, 5000)
+            buzzer_play(power_load_tone, 1);
 
             // Sets the tick rate to 1 sec while button is down.
             // tick_rate_set_sec(1);
@@ -106,7 +170,7 @@ switch (EVENT_TYPE(event))
             // Get battery voltage without backlight on, the next update will
             // be in 2 minutes.
             battery_voltage = battery_read_voltage();
-            display_primary_number(7, lroundf(battery_voltage*100));
+            power_view_draw();
         }
         else if (EVENT_DATA(event) == '+')
         {
@@ -125,7 +189,8 @@ switch (EVENT_TYPE(event))
         {
             // Adj button resets the rolling average.
             battery_voltage = battery_read_voltage();
-            display_primary_number(7, lroundf(battery_voltage*100));
+            power_view = POWER_VIEW_LIVE;
+            power_view_draw();
         }
     break;
     
@@ -139,7 +204,123 @@ switch (EVENT_TYPE(event))
 void
 power_stop (void)
 {
+    display_period_clear(1);
+    display_period_clear(5);
+}
+
+void
+powerd (unsigned int event)
+{
+    if (event == EVENT_ID(EVENT_ALARM, POWER_ALARM_EVENT))
+    {
+        // Record the daily battery reading.
+        battery_history_record();
+
+        // Register another alarm for tomorrow.
+        alarm_set_time(&noon, POWER_ALARM_EVENT);
+    }
+    else if (event == EVENT_ID(EVENT_ALARM, ALARM_EVENT_MISSED))
+    {
+        datetime_t missed;
+
+        // Take the reading we missed while we were reset. The alarm was
+        // already registered again by power_init().
+        if (alarm_missed(POWER_ALARM_EVENT, &missed))
+        {
+            battery_history_record();
+        }
+    }
+}
+
+static void
+power_view_draw (void)
+{
+    unsigned char count = battery_history_count();
+    signed long days = 0;
+
+    display_primary_clear(0);
+    display_period_clear(1);
     display_period_clear(5);
+
+    switch (power_view)
+    {
+    case POWER_VIEW_LIVE:
+        display_secondary_string(1, "bA");
+        display_primary_string(1, "bat");
+        display_primary_character(8, 'V');
+        display_primary_number(7, lroundf(battery_voltage*100));
+        display_period(5);
+    break;
+
+    case POWER_VIEW_HISTORY:
+        // Days recorded in the secondary, oldest and newest voltage in the
+        // primary: "3.01-2.95V"
+        display_secondary_number(2, count);
+
+        if (count)
+        {
+            display_primary_number(3, battery_history_get(count - 1) / 10);
+            display_primary_character(4, '-');
+            display_primary_number(7, battery_history_get(0) / 10);
+            display_primary_character(8, 'V');
+            display_period(1);
+            display_period(5);
+        }
+        else
+        {
+            display_primary_string(1, "no dAtA");
+        }
+    break;
+
+    case POWER_VIEW_ESTIMATE:
+        display_secondary_string(1, "dL");
+
+        days = power_days_left();
+        if (0 > days)
+        {
+            display_primary_string(-1, "----");
+        }
+        else
+        {
+            display_primary_number(-1, days);
+        }
+    break;
+
+    default:
+    break;
+    }
+}
+
+static signed long
+power_days_left (void)
+{
+    unsigned char count = battery_history_count();
+    unsigned int oldest = 0;
+    unsigned int newest = 0;
+
+    // We need at least two days to calculate a drop.
+    if (2 > count)
+    {
+        return -1;
+    }
+
+    oldest = battery_history_get(count - 1);
+    newest = battery_history_get(0);
+
+    if (POWER_CUTOFF_MV >= newest)
+    {
+        return 0;
+    }
+
+    if (oldest <= newest)
+    {
+        // No measurable drop yet.
+        return -1;
+    }
+
+    // Days left = remaining mV / average drop per day
+    return ((signed long)(newest - POWER_CUTOFF_MV) * (count - 1)) \
+            / (signed long)(oldest - newest);
 }
 
 // EOF //
@@ -6,16 +6,21 @@
 #ifndef _power_h_
 #define _power_h_
 
+#define POWER_ALARM_EVENT   0xBA
+
+void            power_init  (void);
 void            power_start (void);
 signed char     power_run   (unsigned int event);
 void            power_stop  (void);
+void            powerd      (unsigned int event);
 
 mode_app_t power_mode = {
         "power",
-        NULL,
+        &power_init,
         &power_start,
         &power_run,
         &power_stop,
+        &powerd
 };
 
 #endif
@@ -10,6 +10,7 @@
 #include "lib/mode.h"
 #include "lib/events.h"
 #include "lib/tick.h"
+#include "lib/timeout.h"
 #include "lib/display.h"
 #include "lib/buttons.h"
 #include "lib/keypad.h"
@@ -23,6 +24,9 @@
 
 #define SETTINGS_KEYMAP KEYMAP_DIRECTIONAL
 
+// Blink rate of the '=' sign when editing a value
+#define SETTINGS_BLINK  TIMEOUT_MS(500)
+
 // Holds the current setting id and value
 static unsigned char settings_active_id = 0;
 static unsigned char settings_active_value = 0;
@@ -30,14 +34,12 @@ static unsigned char settings_active_value = 0;
 // Holds the current value being edited
 static unsigned char edit_value = 0;
 
-// Variable to determine if we should blink when editing value
-unsigned char is_blinking = 0;
-
 // Alternative mode functions
 signed char settings_edit (unsigned int event);
 
 // Display setting's ID and value
 static void settings_display (unsigned char id);
+static void settings_display_step (signed char step);
 static void settings_display_edit (void);
 
 
@@ -81,24 +83,24 @@ settings_run (unsigned int event)
         if ('>' == keycode)
         {
             // Next setting
-            settings_display(settings_active_id + 1);
+            settings_display_step(1);
         }
         if ('<' == keycode)
         {
             // Previous setting
-            settings_display(settings_active_id - 1);
+            settings_display_step(-1);
         }
         if ('^' == keycode)
         {
             // Next setting +10
             // settings_active_id += 10;
-            settings_display(settings_active_id + 10);
+            settings_display_step(10);
         }
         if ('v' == keycode)
         {
             // previous setting -10
             // settings_active_id -= 10;
-            settings_display(settings_active_id - 10);
+            settings_display_step(-10);
         }
     break;
 
@@ -113,8 +115,7 @@ settings_run (unsigned int event)
             edit_value = settings_active_value;
             keypad_keymap_set(KEYMAP_CASIO);
             settings_mode.run = &settings_edit;
-            tick_rate_set_ms(500); // Set tickrate to 500ms for blinking
-            is_blinking = 1; // We want to blink off the bat
+            display_primary_blink(4, SETTINGS_BLINK); // Blink the equal sign
         }
     break;
 
@@ -135,21 +136,6 @@ settings_edit (unsigned int event)
 
     switch (EVENT_TYPE(event))
     {
-    case EVENT_TICK:
-        if (is_blinking)
-        {
-            // Clear equal sign
-            display_primary_clear(4);
-            is_blinking = 0;
-        }
-        else
-        {
-            // Display equal sign
-            display_primary_character(4, '=');
-            is_blinking = 1;
-        }
-    break;
-
     case KEYPAD_EVENT_PRESS:
         keypress = EVENT_DATA(event);
         if ('0' <= keypress && keypress <= '9')
@@ -159,7 +145,6 @@ settings_edit (unsigned int event)
             edit_value = (edit_value * 10) + keypress;  // Add keypress as LSD.
             // Display new value.
             settings_display_edit();
-            is_blinking = 0;
         }
         if ('.' == keypress)
         {
@@ -168,7 +153,6 @@ settings_edit (unsigned int event)
 
             // Display new value
             settings_display_edit();
-            is_blinking = 0;
         }
     break;
 
@@ -179,7 +163,7 @@ settings_edit (unsigned int event)
             settings_display(settings_active_id);      // Display value
             keypad_keymap_set(SETTINGS_KEYMAP);    // Set keymap back
             settings_mode.run = &settings_run;      // Set run loop back
-            tick_disable(); // disable ticks
+            display_blink_clear(); // Stop blinking
         }
         else if (EVENT_DATA(event) == BUTTON_ADJ_PRESS)
         {
@@ -192,7 +176,7 @@ settings_edit (unsigned int event)
             keypad_keymap_set(SETTINGS_KEYMAP);    // Set keymap back
             settings_display(settings_active_id);      // Display set value
             settings_mode.run = &settings_run;      // Set run loop back
-            tick_disable(); // disable ticks
+            display_blink_clear(); // Stop blinking
             // Adj button up returns to main settings loop
         }
         else if (EVENT_DATA(event) == BUTTON_ADJ_RELEASE)
@@ -219,6 +203,24 @@ settings_display (unsigned char setting_index)
     display_primary_number(8, settings_active_value); // Display value
 }
 
+static void
+settings_display_step (signed char step)
+{
+    signed int id = (signed int)settings_active_id + step;
+
+    // IDs from the settings header up aren't settings.
+    if (id < 0)
+    {
+        id = 0;
+    }
+    if (id >= SETTINGS_HEADER_ADDRESS)
+    {
+        id = SETTINGS_HEADER_ADDRESS - 1;
+    }
+
+    settings_display((unsigned char)id);
+}
+
 static void
 settings_display_edit (void)
 {
@@ -8,10 +8,12 @@
 #include "lib/mode.h"
 #include "lib/events.h"
 #include "lib/tick.h"
+#include "lib/timeout.h"
 #include "lib/display.h"
 #include "lib/buttons.h"
 #include "lib/keypad.h"
 #include "lib/buzzer.h"
+#include "lib/rtttl.h"
 #include "lib/backlight.h"
 
 #include "lib/logging.h"
@@ -26,10 +28,12 @@
 
 
 // Test string to scroll across the main display
-static const char * test_display_string_marker;
 static const char test_display_string[] = 
     "The quick brown fox jumps over the lazy dog 1234567890.";
 
+// Scroll rate of the test string. (1/2 sec)
+#define TEST_SCROLL_RATE    TIMEOUT_MS(500)
+
 
 void
 test_init (void)
@@ -42,8 +46,8 @@ test_start (void)
 {
     LOG_INFO("Starting World!");
 
-    // Set tickrate to scroll rate. (1/2 sec)
-    tick_rate_set_ms(500);
+    // Scroll our test string across the main display.
+    display_primary_scroll(test_display_string, TEST_SCROLL_RATE, DISPLAY_SCROLL_LOOP);
 }
 
 signed char
@@ -54,15 +58,6 @@ test_run (unsigned int event)
     switch (EVENT_TYPE(event))
     {
 
-    case EVENT_TICK:
-        // For every tick event we move our scroll string and display it.
-        display_primary_string(1, test_display_string_marker++);
-        if (*test_display_string_marker == '\0')
-        {
-            test_display_string_marker = &test_display_string[0];
-        }
-    break;
-
     case KEYPAD_EVENT_PRESS:
         LOG_INFO("Keypress: %c", EVENT_DATA(event));
 
@@ -75,17 +70,11 @@ test_run (unsigned int event)
         // Manually update the display for our keypress
         display_update();
 
-        // Disable ticks while we play a song
-        tick_disable();
-
         // Also play a song
         // static char song[] = "DKCountry:d=4,o=5,b=125:32p,8c,8c,a.,p,8f,8g,8f,d.,p,8d,8d,a#.,p,8g,8a,8g,e.,p,8e,8e,c.6,p,8a,8a#,8c6,d.6,p,8f,8g,a,f,8p,8e,8f,8g,d.";
         // static char song[] = "Jeopardy:d=4,o=6,b=125:c,f,c,f5,c,f,2c,c,f,c,f,a.,8g,8f,8e,8d,8c#,c,f,c,f5,c,f,2c,f.,8d,c,a#5,a5,g5,f5,p,d#,g#,d#,g#5,d#,g#,2d#,d#,g#,d#,g#,c.7,8a#,8g#,8g,8f,8e,d#,g#,d#,g#5,d#,g#,2d#,g#.,8f,d#,c#,c,p,a#5,p,g#.5,d#,g#";
-        static char song[] = "Mario:d=4,o=5,b=115:32p,16e6,16e6,16p,16e6,16p,16c6,16e6,16p,16g6,8p,16p,16g,8p,32p,16c6,8p,16g,8p,16e,8p,16a,16p,16b,16p,16a#,16a,16p,16g,16e6,16g6,16a6,16p,16f6,16g6,16p,16e6,16p,16c6,16d6,16b,p,16g6,16f#6,16f6,16d#6,16p,16e6,16p,16g#,16a,16c6,16p,16a,16c6,16d6,8p,8d#6,16p,16d6,8p,8c6";
-        buzzer_play_rtttl(song);
-
-        // Enable ticks after we're done
-        tick_enable();
+        static const buzzer_note_t song[] = { RTTTL_MARIO(115) };
+        buzzer_play(song, sizeof(song) / sizeof(song[0]));
     break;
 
     case KEYPAD_EVENT_RELEASE:
@@ -100,21 +89,21 @@ test_run (unsigned int event)
         switch (EVENT_DATA(event))
         {
         case BUTTON_MODE_PRESS:
+            display_scroll_stop();
             display_primary_string(0, "MODE DN");
-            tick_disable();
         break;
         case BUTTON_MODE_RELEASE:
             display_primary_string(0, "MODE UP");
-            tick_enable();
+            display_primary_scroll(test_display_string, TEST_SCROLL_RATE, DISPLAY_SCROLL_LOOP);
         break;
 
         case BUTTON_ADJ_PRESS:
+            display_scroll_stop();
             display_primary_string(0, "ADJ DN");
-            tick_disable();
         break;
         case BUTTON_ADJ_RELEASE:
             display_primary_string(0, "ADJ UP");
-            tick_enable();
+            display_primary_scroll(test_display_string, TEST_SCROLL_RATE, DISPLAY_SCROLL_LOOP);
         break;
         }
 
@@ -12,6 +12,7 @@
 #include "lib/buttons.h"
 #include "lib/keypad.h"
 #include "lib/buzzer.h"
+#include "lib/rtttl.h"
 #include "lib/backlight.h"
 #include "lib/datetime.h"
 #include "lib/alarm.h"
@@ -454,8 +455,8 @@ timerd (unsigned int event)
                 }
                 LOG_DEBUG("Countdown ended");
                 // Play mario song
-                static char song[] = "Mario:d=4,o=5,b=200:32p,16e6,16e6,16p,16e6,16p,16c6,16e6,16p,16g6,8p,16p,16g,8p,32p,16c6,8p,16g,8p,16e,8p,16a,16p,16b,16p,16a#,16a,16p,16g,16e6,16g6,16a6,16p,16f6,16g6,16p,16e6,16p,16c6,16d6,16b,p,16g6,16f#6,16f6,16d#6,16p,16e6,16p,16g#,16a,16c6,16p,16a,16c6,16d6,8p,8d#6,16p,16d6,8p,8c6";
-                buzzer_play_rtttl(song);
+                static const buzzer_note_t song[] = { RTTTL_MARIO(200) };
+                buzzer_play(song, sizeof(song) / sizeof(song[0]));
             break;
 
             default:
@@ -481,9 +482,9 @@ static void
 timer_display_time (time_t *time)
 {
     display_primary_string(1, "00 00 00");
-    display_primary_number(2, BCD2DEC(time->hour));
-    display_primary_number(5, BCD2DEC(time->minute));
-    display_primary_number(8, BCD2DEC(time->second));
+    display_primary_bcd(2, time->hour, 2);
+    display_primary_bcd(5, time->minute, 2);
+    display_primary_bcd(8, time->second, 2);
 }
 
 // This helper function adds timeB to timeA.
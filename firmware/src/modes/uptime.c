@@ -37,13 +37,16 @@ static time_t midnight = {0x00, 0x00, 0x00};
 void
 uptime_init (void)
 {
+    datetime_t alarm_datetime;
+
     // Load saved uptime from EEPROM
-    // current_uptime = settings_get_int(SETTING_UPTIME_H, SETTING_UPTIME_L);
-    // current_uptime = settings_get(SETTING_UPTIME_H);
-    // current_uptime |= settings_get(SETTING_UPTIME_L);
+    current_uptime = settings_get_int(SETTING_UPTIME_H, SETTING_UPTIME_L);
 
-    // Register alarm for day counter
-    alarm_set_time(&midnight, 0xAE);
+    // Register alarm for day counter, unless it was restored after a reset.
+    if (!alarm_find_event(UPTIME_ALARM_EVENT, &alarm_datetime))
+    {
+        alarm_set_time(&midnight, UPTIME_ALARM_EVENT);
+    }
 }
 
 void
@@ -137,7 +140,25 @@ uptimed (unsigned int event)
         settings_set_int(SETTING_UPTIME_H, SETTING_UPTIME_L, ++current_uptime);
 
         // Register another alarm for next time
-        alarm_set_time(&midnight, 0xAE);
+        alarm_set_time(&midnight, UPTIME_ALARM_EVENT);
+    }
+    else if (event == EVENT_ID(EVENT_ALARM, ALARM_EVENT_MISSED))
+    {
+        datetime_t missed;
+        datetime_t now;
+
+        // Count the midnights that passed while we were reset. The alarm was
+        // already registered again by uptime_init().
+        if (alarm_missed(UPTIME_ALARM_EVENT, &missed))
+        {
+            datetime_now(&now);
+            if (datetime_epoch(&now) >= datetime_epoch(&missed))
+            {
+                current_uptime += (unsigned int)
+                    ((datetime_epoch(&now) - datetime_epoch(&missed)) / 86400UL) + 1;
+                settings_set_int(SETTING_UPTIME_H, SETTING_UPTIME_L, current_uptime);
+            }
+        }
     }
 }
 
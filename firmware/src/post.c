@@ -6,6 +6,7 @@
 #include <xc.h>
 
 #include "lib/datetime.h"
+#include "lib/timeout.h"
 #include "lib/display.h"
 #include "lib/keypad.h"
 #include "lib/buttons.h"
@@ -20,6 +21,8 @@
 
 #define POST_SPLASH "PowerPIC"
 
+#define POST_SPLASH_RATE    TIMEOUT_MS(150)
+
 static time_t post_time = {0};
 
 void
@@ -40,11 +43,21 @@ post_bios (void)
 
     // The start of a our post is a splash screen of sorts.
     // 'PowerPIC' sliding in from the right
-    for (signed char offset=8; offset != 0; offset--)
+    display_primary_scroll(POST_SPLASH, POST_SPLASH_RATE, DISPLAY_SCROLL_ONCE);
+    while (display_scroll_active())
     {
-        display_primary_string(offset, POST_SPLASH);
+        // The scroll moves along whenever its timeout has expired.
         display_update();
-        __delay_ms(150);
+
+        // Sleep until the next step is due, same as the main loop.
+#       if LOG_LVL
+        while (!logging_buffer_empty() || !TX1STAbits.TRMT)
+        {
+            // Wait for transmit buffer to empty
+        }
+#       endif
+        SLEEP();
+        NOP();
     }
 
     // POST Code 2
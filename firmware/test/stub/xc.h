@@ -0,0 +1,145 @@
+/** @file xc.h
+ *
+ * Stand-in for the XC8 device header, so parts of the firmware can be built
+ * with the host compiler for the tests.
+ *
+ * Special function registers are plain variables. Each test is built as a
+ * single translation unit that includes the sources it tests, so they are
+ * defined right here. A test that drives the column pins of the keypad itself
+ * defines PORTC as a macro before including any source.
+*/
+
+#ifndef _xc_h_
+#define _xc_h_
+
+// Compiler builtins and instructions.
+#define __interrupt(...)
+#define __delay_ms(ms)
+#define __delay_us(us)
+#define di()
+#define ei()
+#define SLEEP()
+#define NOP()
+#define CLRWDT()
+
+/**
+ * Every bit field of the registers the tests use, all in one type. The
+ * fields are whole bytes, the tests only look at the values written.
+*/
+typedef struct
+{
+    unsigned char GIE;
+    unsigned char nPOR;
+
+    // LCD
+    unsigned char CS;
+    unsigned char LMUX;
+    unsigned char LCDEN;
+    unsigned char LCDVSRC;
+    unsigned char WFT;
+    unsigned char LP;
+    unsigned char WA;
+    unsigned char LCDIE;
+    unsigned char LCDIF;
+
+    // Pins
+    unsigned char IOCIE;
+    unsigned char TRISG6;
+    unsigned char TRISG7;
+
+    // Timers and PWM
+    unsigned char ON;
+    unsigned char CKPS;
+    unsigned char PSYNC;
+    unsigned char P4TSEL;
+    unsigned char PWM4EN;
+
+    // RTCC
+    unsigned char RTCEN;
+    unsigned char RTCWREN;
+    unsigned char RTCSYNC;
+    unsigned char RTCCLKSEL;
+    unsigned char ALRMEN;
+    unsigned char AMASK;
+    unsigned char RTCCIE;
+    unsigned char RTCCIF;
+} xc_bits_t;
+
+// Registers with bit fields.
+volatile xc_bits_t INTCONbits;
+volatile xc_bits_t PCON0bits;
+
+// LCD
+volatile xc_bits_t LCDCONbits;
+volatile xc_bits_t LCDPSbits;
+volatile xc_bits_t LCDVCON2bits;
+volatile xc_bits_t PIE8bits;
+volatile xc_bits_t PIR8bits;
+
+#define _PIR8_LCDIF_MASK    0x04
+
+/** The LCDDATA registers follow each other, the driver indexes them. */
+volatile unsigned char xc_lcddata[24];
+#define LCDDATA0            (xc_lcddata[0])
+
+volatile unsigned char LCDVCON1;
+volatile unsigned char LCDSE0;
+volatile unsigned char LCDSE1;
+volatile unsigned char LCDSE2;
+volatile unsigned char LCDSE3;
+volatile unsigned char LCDSE4;
+volatile unsigned char LCDSE5;
+
+// Pins
+volatile xc_bits_t PIE0bits;
+
+#define _PIR0_IOCIF_MASK    0x10
+
+volatile unsigned char TRISA;
+volatile unsigned char LATA;
+volatile unsigned char PORTA;
+volatile unsigned char TRISC;
+volatile unsigned char LATC;
+#ifndef PORTC
+volatile unsigned char PORTC;
+#endif
+volatile unsigned char WPUC;
+volatile unsigned char IOCCF;
+volatile xc_bits_t TRISGbits;
+volatile unsigned char RG6PPS;
+volatile unsigned char RG7PPS;
+
+// Timers and PWM
+volatile xc_bits_t T4CONbits;
+volatile xc_bits_t T4HLTbits;
+volatile xc_bits_t CCPTMRS0bits;
+volatile xc_bits_t PWM4CONbits;
+volatile unsigned char T4PR;
+
+/** Both bytes of the duty cycle, PWM4DCH:PWM4DCL. */
+volatile unsigned int PWM4DC;
+
+// RTCC
+volatile xc_bits_t RTCCONbits;
+volatile xc_bits_t ALRMCONbits;
+
+#define _PIR8_RTCCIF_MASK   0x80
+
+volatile unsigned char YEAR;
+volatile unsigned char MONTH;
+volatile unsigned char DAY;
+volatile unsigned char WEEKDAY;
+volatile unsigned char HOURS;
+volatile unsigned char MINUTES;
+volatile unsigned char SECONDS;
+volatile unsigned char ALRMMTH;
+volatile unsigned char ALRMDAY;
+volatile unsigned char ALRMWD;
+volatile unsigned char ALRMHR;
+volatile unsigned char ALRMMIN;
+volatile unsigned char ALRMSEC;
+volatile unsigned char RTCCAL;
+
+#endif
+
+// EOF //
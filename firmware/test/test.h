@@ -0,0 +1,67 @@
+/** @file test.h
+ *
+ * Checks for the host tests.
+ *
+ * A test includes the firmware sources it tests, runs its checks with
+ * TEST_CHECK() and returns TEST_RESULT() from main().
+*/
+
+#ifndef _test_h_
+#define _test_h_
+
+#include <stdio.h>
+
+/** Number of checks run. */
+static unsigned long test_checks = 0;
+
+/** Number of checks that failed. */
+static unsigned long test_failures = 0;
+
+/**
+ * Check a condition. A failed check is printed with a message in printf
+ * format. Only the first few failures are printed.
+*/
+#define TEST_CHECK(condition, ...)                                          \
+    do {                                                                    \
+        test_checks++;                                                      \
+        if (!(condition))                                                   \
+        {                                                                   \
+            if (test_failures++ < 10)                                       \
+            {                                                               \
+                printf("%s:%d: ", __FILE__, __LINE__);                      \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+/** Print a summary of the checks, the exit code of a test. */
+#define TEST_RESULT()                                                       \
+    (printf("%s: %lu checks, %lu failed\n",                                 \
+        __FILE__, test_checks, test_failures), (test_failures ? 1 : 0))
+
+/** State of test_random(). */
+static unsigned long test_random_state = 1;
+
+/**
+ * Pseudo random numbers, the same on every run so failures can be repeated.
+ *
+ * @returns     A random 32-bit number.
+*/
+static unsigned long
+test_random (void)
+{
+    // xorshift32
+    unsigned long x = test_random_state;
+
+    x ^= (x << 13) & 0xFFFFFFFFUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xFFFFFFFFUL;
+    test_random_state = x & 0xFFFFFFFFUL;
+
+    return test_random_state;
+}
+
+#endif
+
+// EOF //
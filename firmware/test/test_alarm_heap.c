@@ -0,0 +1,361 @@
+/** @file test_alarm_heap.c
+ *
+ * Checks the alarm heap against a plain list of alarms.
+ *
+ * Alarms are added, deleted and go off at random, on the alarm lib and on an
+ * unsorted reference list. After every step the registered alarms have to be
+ * a min-heap holding the same alarms as the list, with the RTCC alarm
+ * registers set to the earliest of them. Alarms can be days away, so the
+ * RTCC matches their time of day before they are due. After a power on reset
+ * every stored alarm has to be missed.
+ *
+ * It also counts the steps alarms move through the heap when one is
+ * registered or the next one goes off, for heaps of a few sizes up to the
+ * 255 alarms ALARM_MAX_ALARMS allows, and prints them.
+*/
+
+/** Room for the largest heap. */
+#define ALARM_MAX_ALARMS    255
+
+/** Steps counted by ALARM_SIFT_STEP() in alarm.c. */
+static unsigned long count_sift_steps = 0;
+
+#define ALARM_SIFT_STEP()   (count_sift_steps++)
+
+#include "lib/datetime.c"
+#undef LOG_TAG
+#include "drivers/rtcc.c"
+#include "lib/alarm.c"
+
+#include "test.h"
+
+
+/** Number of events sent for each event data. */
+static unsigned int events[256];
+
+void
+event_isr (unsigned int id)
+{
+    events[EVENT_DATA(id)]++;
+}
+
+// EEPROM, blank until the alarms are flushed.
+static unsigned char eeprom[256];
+
+unsigned char
+eeprom_read (unsigned char address)
+{
+    return eeprom[address];
+}
+
+void
+eeprom_write (unsigned char address, unsigned char data)
+{
+    eeprom[address] = data;
+}
+
+// Not part of the test.
+signed char isr_register (unsigned char reg, unsigned char mask, void (*isr)(void)) { return 0; }
+
+
+/** Current time of the simulated RTCC, in seconds since 2000. */
+static unsigned long now;
+
+/** Set the RTCC time and date registers. */
+static void
+clock_set (unsigned long epoch)
+{
+    datetime_t dt;
+
+    datetime_from_epoch(epoch, &dt);
+
+    HOURS = dt.time.hour;
+    MINUTES = dt.time.minute;
+    SECONDS = dt.time.second;
+    YEAR = dt.date.year;
+    MONTH = dt.date.month;
+    DAY = dt.date.day;
+    WEEKDAY = dt.date.weekday;
+
+    now = epoch;
+}
+
+/** The reference, an unsorted list of the registered alarms. */
+static unsigned long reference_epochs[ALARM_MAX_ALARMS];
+static unsigned char reference_events[ALARM_MAX_ALARMS];
+static unsigned char reference_count = 0;
+
+/** Index in the reference of the earliest alarm. */
+static unsigned char
+reference_head (void)
+{
+    unsigned char head = 0;
+
+    for (unsigned char i = 1; i < reference_count; i++)
+    {
+        if (reference_epochs[i] < reference_epochs[head])
+        {
+            head = i;
+        }
+    }
+
+    return head;
+}
+
+/** Remove an alarm from the reference. */
+static void
+reference_remove (unsigned char index)
+{
+    reference_count--;
+    reference_epochs[index] = reference_epochs[reference_count];
+    reference_events[index] = reference_events[reference_count];
+}
+
+/** Check the registered alarms against the reference. */
+static void
+check_alarms (unsigned long step)
+{
+    unsigned char found[ALARM_MAX_ALARMS] = {0};
+
+    TEST_CHECK(reference_count == registered_alarms_count,
+        "step %lu: %u alarms, expected %u", step, registered_alarms_count, reference_count);
+    if (reference_count != registered_alarms_count)
+    {
+        return;
+    }
+
+    for (unsigned char i = 1; i < registered_alarms_count; i++)
+    {
+        TEST_CHECK(registered_alarms[(i - 1) / 2].epoch <= registered_alarms[i].epoch,
+            "step %lu: alarm %u is earlier than its parent", step, i);
+    }
+
+    // Every alarm is in the reference once.
+    for (unsigned char i = 0; i < registered_alarms_count; i++)
+    {
+        unsigned char r;
+
+        for (r = 0; r < reference_count; r++)
+        {
+            if (!found[r]
+                && (reference_epochs[r] == registered_alarms[i].epoch)
+                && (reference_events[r] == registered_alarms[i].event_data))
+            {
+                found[r] = 1;
+                break;
+            }
+        }
+
+        TEST_CHECK(r < reference_count,
+            "step %lu: alarm %u at %lu isn't registered", step, i, registered_alarms[i].epoch);
+    }
+
+    if (registered_alarms_count)
+    {
+        datetime_t head;
+
+        datetime_from_epoch(reference_epochs[reference_head()], &head);
+
+        TEST_CHECK(ALRMCONbits.ALRMEN,
+            "step %lu: alarm isn't enabled", step);
+        TEST_CHECK((head.time.hour == ALRMHR) && (head.time.minute == ALRMMIN),
+            "step %lu: alarm set to %02X:%02X, expected %02X:%02X",
+            step, ALRMHR, ALRMMIN, head.time.hour, head.time.minute);
+    }
+}
+
+/** Depth of the last alarm of a heap, 0 for a single alarm. */
+static unsigned char
+heap_depth (unsigned int count)
+{
+    unsigned char depth = 0;
+
+    while (count >>= 1)
+    {
+        depth++;
+    }
+
+    return depth;
+}
+
+/**
+ * Count the steps of registering an alarm and of the next one going off,
+ * with a heap of a given size.
+*/
+static void
+benchmark (unsigned char size)
+{
+    unsigned long insert_steps = 0;
+    unsigned long remove_steps = 0;
+    unsigned long insert_worst = 0;
+    unsigned long remove_worst = 0;
+
+    registered_alarms_count = 0;
+    for (unsigned char i = 0; i < size; i++)
+    {
+        alarm_add(now + 1 + test_random() % (30 * DAY_SECONDS), 0);
+    }
+
+    for (unsigned int round = 0; round < 1000; round++)
+    {
+        count_sift_steps = 0;
+        alarm_add(now + 1 + test_random() % (30 * DAY_SECONDS), 0);
+        insert_steps += count_sift_steps;
+        if (insert_worst < count_sift_steps)
+        {
+            insert_worst = count_sift_steps;
+        }
+
+        count_sift_steps = 0;
+        alarm_remove(0);
+        remove_steps += count_sift_steps;
+        if (remove_worst < count_sift_steps)
+        {
+            remove_worst = count_sift_steps;
+        }
+    }
+
+    printf("%3u alarms: register %2lu.%02lu steps (worst %lu), next %2lu.%02lu steps (worst %lu)\n",
+        size,
+        insert_steps / 1000, (insert_steps % 1000) / 10, insert_worst,
+        remove_steps / 1000, (remove_steps % 1000) / 10, remove_worst);
+
+    // An alarm moves at most from the bottom of the heap to the top, or back.
+    TEST_CHECK(insert_worst <= heap_depth(size + 1U),
+        "%u alarms: registering took %lu steps", size, insert_worst);
+    TEST_CHECK(remove_worst <= heap_depth(size) + 1U,
+        "%u alarms: removing the next took %lu steps", size, remove_worst);
+}
+
+int
+main (void)
+{
+    unsigned long step = 0;
+
+    for (unsigned int address = 0; address < sizeof(eeprom); address++)
+    {
+        eeprom[address] = 0xFF;
+    }
+
+    // 2024-02-28 12:00:00, so leap days are crossed as well.
+    clock_set((8766UL + 58) * DAY_SECONDS + 43200UL);
+    alarm_init();
+
+    for (unsigned long round = 0; round < 200; round++)
+    {
+        for (unsigned char ops = 0; ops < 250; ops++, step++)
+        {
+            unsigned char op = (unsigned char)(test_random() % 8);
+
+            if ((op < 4) && (reference_count < ALARM_MAX_ALARMS))
+            {
+                // Up to three days away, with a few at the same second.
+                unsigned long epoch = now + 1 + test_random() % (3 * DAY_SECONDS);
+                unsigned char event_data = (unsigned char)(test_random() % 6);
+
+                if (reference_count && !(test_random() % 8))
+                {
+                    epoch = reference_epochs[test_random() % reference_count];
+                }
+
+                alarm_add(epoch, event_data);
+
+                reference_epochs[reference_count] = epoch;
+                reference_events[reference_count] = event_data;
+                reference_count++;
+            }
+            else if (op < 5)
+            {
+                unsigned char event_data = (unsigned char)(test_random() % 6);
+                unsigned char expected = 0;
+
+                for (unsigned char i = reference_count; i > 0; i--)
+                {
+                    if (event_data == reference_events[i - 1])
+                    {
+                        reference_remove(i - 1);
+                        expected++;
+                    }
+                }
+
+                TEST_CHECK(expected == alarm_del_event(event_data),
+                    "step %lu: deleted the wrong number of alarms", step);
+            }
+            else if (reference_count)
+            {
+                // The RTCC matches the time of day of the head. Half the time
+                // that is on the day the alarm is due.
+                unsigned long head = reference_epochs[reference_head()];
+                unsigned int expected[256] = {0};
+
+                if ((head - now) % DAY_SECONDS)
+                {
+                    clock_set(now + (head - now) % DAY_SECONDS);
+                }
+                if (test_random() & 1)
+                {
+                    clock_set(head);
+                }
+
+                for (unsigned char i = reference_count; i > 0; i--)
+                {
+                    if (reference_epochs[i - 1] <= now)
+                    {
+                        expected[reference_events[i - 1]]++;
+                        reference_remove(i - 1);
+                    }
+                }
+
+                alarm_isr();
+
+                for (unsigned int event_data = 0; event_data < 256; event_data++)
+                {
+                    TEST_CHECK(expected[event_data] == events[event_data],
+                        "step %lu: event %u sent %u times, expected %u",
+                        step, event_data, events[event_data], expected[event_data]);
+                    events[event_data] = 0;
+                }
+            }
+
+            check_alarms(step);
+        }
+
+        alarm_flush();
+    }
+
+    // A power on reset starts the RTCC over from a default date that is
+    // earlier than the stored alarms, but they are all missed.
+    unsigned char stored = 0;
+
+    for (unsigned char slot = 0; slot < ALARM_STORE_SLOTS; slot++)
+    {
+        if (ALARM_STORE_FREE != eeprom[ALARM_STORE_SLOT(slot)])
+        {
+            stored++;
+        }
+    }
+    TEST_CHECK(stored, "no alarms were stored");
+
+    PCON0bits.nPOR = 0;
+    datetime_init();
+    registered_alarms_count = 0;
+    events[ALARM_EVENT_MISSED] = 0;
+    alarm_init();
+
+    TEST_CHECK(0 == registered_alarms_count,
+        "%u alarms registered after a power on reset", registered_alarms_count);
+    TEST_CHECK(stored == alarm_missed_count,
+        "%u of %u stored alarms missed after a power on reset", alarm_missed_count, stored);
+    TEST_CHECK(1 == events[ALARM_EVENT_MISSED],
+        "missed alarms sent %u times", events[ALARM_EVENT_MISSED]);
+
+    benchmark(1);
+    benchmark(4);
+    benchmark(16);
+    benchmark(64);
+    benchmark(254);
+
+    return TEST_RESULT();
+}
+
+// EOF //
@@ -0,0 +1,236 @@
+/** @file test_display_bcd.c
+ *
+ * Checks the binary to BCD conversion of the display lib.
+ *
+ * display_bcd_encode() is compared against converting with division, and
+ * the numbers drawn by display_primary_number() against printf().
+ *
+ * It also draws the same numbers the old way, with a % 10 and a /= 10 for
+ * every digit, and prints the divisions and host cycles each way takes for a
+ * number. The PIC has no divide instruction, so the divisions are done one
+ * bit at a time in software like the compiler's runtime library does.
+*/
+
+#include "drivers/lcd.c"
+#include "lib/display/display.c"
+#include "lib/display/display_primary.c"
+#include "lib/display/display_secondary.c"
+#include "lib/display/fonts.c"
+
+#include "test.h"
+
+
+// Only the drawing of the display is tested.
+signed char isr_register (unsigned char reg, unsigned char mask, void (*isr)(void)) { return 0; }
+unsigned char display_wake (void) { return 0; }
+void display_scroll_update (void) {}
+
+/** Divisions done by old_primary_number(). */
+static unsigned long count_divisions = 0;
+
+/** Unsigned 32-bit division without a divide instruction, as on the PIC. */
+static unsigned long
+divide_soft (unsigned long dividend, unsigned long divisor, unsigned long *remainder)
+{
+    unsigned long quotient = 0;
+    unsigned long rest = 0;
+
+    count_divisions++;
+
+    for (unsigned char bit = 32; bit--; )
+    {
+        rest = (rest << 1) | ((dividend >> bit) & 1);
+        quotient <<= 1;
+
+        if (rest >= divisor)
+        {
+            rest -= divisor;
+            quotient |= 1;
+        }
+    }
+
+    *remainder = rest;
+    return quotient;
+}
+
+// The / and % of the old way, both are a division.
+static long
+divide (long dividend, long divisor)
+{
+    unsigned long remainder;
+
+    return (long)divide_soft((unsigned long)dividend, (unsigned long)divisor, &remainder);
+}
+
+static long
+modulo (long dividend, long divisor)
+{
+    unsigned long remainder;
+
+    divide_soft((unsigned long)dividend, (unsigned long)divisor, &remainder);
+    return (long)remainder;
+}
+
+/** display_primary_number() as it was before double dabble. */
+static void
+old_primary_number (signed char position, long number)
+{
+    if (0 == number)
+    {
+        display_primary_character(position, 0);
+    }
+    else if (-9999999 > number || number > 99999999)
+    {
+        display_primary_string(position, "Er");
+    }
+    else
+    {
+        unsigned char negative_number = 0;
+
+        position = position_normalize(position, LCD_PRIMARY_CHARACTERS);
+
+        if (0 > number)
+        {
+            negative_number = 1;
+            number = -number;
+        }
+
+        while (0 < number && 0 < position)
+        {
+            display_primary_character(position--, (unsigned char)modulo(number, 10));
+            number = divide(number, 10);
+        }
+
+        if (negative_number)
+        {
+            display_primary_character(position, '-');
+        }
+    }
+}
+
+/** Host cycle counter, only used to compare the two ways. */
+#if defined(__x86_64__) || defined(__i386__)
+#   define host_cycles()    __builtin_ia32_rdtsc()
+#else
+#   define host_cycles()    0ULL
+#endif
+
+/** Numbers drawn by benchmark(). */
+#define BENCHMARK_NUMBERS   100000
+
+/** Draw random numbers and print the work it took for a number. */
+static void
+benchmark (const char *name, void (*draw)(signed char, long))
+{
+    unsigned long long cycles;
+
+    test_random_state = 1;
+    count_divisions = 0;
+    cycles = host_cycles();
+
+    for (unsigned long round = 0; round < BENCHMARK_NUMBERS; round++)
+    {
+        long number = (long)(test_random() % 100000000);
+
+        draw(8, (round & 1) ? -(number % 10000000) : number);
+    }
+
+    cycles = host_cycles() - cycles;
+
+    printf("%-14s %2lu.%02lu divisions, %5llu host cycles per number\n",
+        name,
+        count_divisions / BENCHMARK_NUMBERS,
+        (count_divisions % BENCHMARK_NUMBERS) * 100 / BENCHMARK_NUMBERS,
+        cycles / BENCHMARK_NUMBERS);
+}
+
+/** BCD of a number, one digit at a time with division. */
+static unsigned long
+reference_bcd (unsigned long binary)
+{
+    unsigned long bcd = 0;
+
+    for (unsigned char shift = 0; binary; shift += 4)
+    {
+        bcd |= (binary % 10) << shift;
+        binary /= 10;
+    }
+
+    return bcd;
+}
+
+/** Check the conversion of a number. */
+static void
+check_bcd (unsigned long binary)
+{
+    unsigned long bcd = display_bcd_encode(binary);
+
+    TEST_CHECK(reference_bcd(binary) == bcd,
+        "%lu encoded as 0x%08lX", binary, bcd);
+}
+
+/** Check a number drawn to the primary display. */
+static void
+check_number (void (*draw)(signed char, long), long number)
+{
+    char text[LCD_PRIMARY_CHARACTERS + 1];
+
+    display_primary_clear(0);
+    draw(8, number);
+
+    snprintf(text, sizeof(text), "%8ld", number);
+
+    for (unsigned char position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+    {
+        TEST_CHECK(character_normalize(text[position - 1]) == display_primary_buffer[position],
+            "%ld drawn with 0x%02X at position %u",
+            number, display_primary_buffer[position], position);
+    }
+}
+
+int
+main (void)
+{
+    display_font = &display_fonts[0];
+
+    // Everything up to 6 digits, then random numbers up to the 8 digits that
+    // fit in the result.
+    for (unsigned long binary = 0; binary <= 999999; binary++)
+    {
+        check_bcd(binary);
+    }
+
+    for (unsigned long round = 0; round < 200000; round++)
+    {
+        check_bcd(test_random() % 100000000);
+    }
+
+    for (unsigned long binary = 1; binary < 100000000; binary *= 10)
+    {
+        check_bcd(binary - 1);
+        check_bcd(binary);
+        check_bcd(binary * 10 - 1);
+    }
+
+    // Everything the primary display can show. The old way is checked too,
+    // so the benchmark compares two ways of drawing the same.
+    for (unsigned long round = 0; round < 20000; round++)
+    {
+        long number = (long)(test_random() % 100000000);
+
+        check_number(&display_primary_number, number);
+        check_number(&display_primary_number, -(number % 10000000));
+        check_number(&old_primary_number, number);
+        check_number(&old_primary_number, -(number % 10000000));
+    }
+
+    check_number(&display_primary_number, 99999999);
+    check_number(&display_primary_number, -9999999);
+
+    benchmark("Division", &old_primary_number);
+    benchmark("Double dabble", &display_primary_number);
+
+    return TEST_RESULT();
+}
+
+// EOF //
@@ -0,0 +1,284 @@
+/** @file test_keypad_bounce.c
+ *
+ * Replays bouncing key presses into the keypad lib.
+ *
+ * Keys are pressed and released on a simulated key matrix, with the contacts
+ * bouncing for a few milliseconds after every change. Every edge on the
+ * column pins runs the keypad ISR and the timeouts run when they are due.
+ * Each press has to give exactly one press and one release event.
+ *
+ * The scans of the key matrix are counted too. However much the contacts
+ * bounce, a key going down or up may only take the scan of its first edge and
+ * the scan that confirms it after debouncing, plus the scans while it is held.
+*/
+
+/** The column pins read back from the simulated key matrix. */
+#define PORTC   matrix_read()
+static unsigned char matrix_read (void);
+
+#include "lib/keypad.c"
+
+#include "test.h"
+
+
+/** Bit of the column pins for each column. */
+#if (1 == PCB_REV)
+static const unsigned char matrix_column_pins[4] = {0x02, 0x01, 0x40, 0x80};
+#else
+static const unsigned char matrix_column_pins[4] = {0x40, 0x80, 0x04, 0x08};
+#endif
+
+/** Keys that are making contact right now, bit n for keycode n. */
+static unsigned int matrix_contacts = 0;
+
+static unsigned char
+matrix_columns (void)
+{
+    unsigned char pins = 0xFF;
+
+    // A key pulls its column low while its row is driven low.
+    for (unsigned char keycode = 0; keycode < 16; keycode++)
+    {
+        if ((matrix_contacts & (1U << keycode)) && !(LATA & (1U << (keycode / 4))))
+        {
+            pins &= (unsigned char)~matrix_column_pins[keycode % 4];
+        }
+    }
+
+    return pins;
+}
+
+/** Scans of the key matrix by the keypad lib. */
+static unsigned long matrix_scans = 0;
+
+/** Rows driven at the last read of the column pins. */
+static unsigned char matrix_rows = 0;
+
+static unsigned char
+matrix_read (void)
+{
+    // A scan starts with row 3 driven low, and reads the columns at least
+    // once for every row.
+    if ((0x07 == (LATA & 0x0F)) && (0x07 != matrix_rows))
+    {
+        matrix_scans++;
+    }
+    matrix_rows = LATA & 0x0F;
+
+    return matrix_columns();
+}
+
+
+// The timeout lib, with the one callback the keypad uses.
+static timeout_callback_t timeout_callback = 0;
+static unsigned long timeout_due = 0;
+
+/** Time in timeout ticks. */
+static unsigned long now = 0;
+
+void
+timeout_set (timeout_callback_t callback, unsigned char ticks)
+{
+    timeout_callback = callback;
+    timeout_due = now + ticks;
+}
+
+void
+timeout_cancel (timeout_callback_t callback)
+{
+    if (callback == timeout_callback)
+    {
+        timeout_callback = 0;
+    }
+}
+
+/** Press and release events emitted for each key. */
+static unsigned int presses[16];
+static unsigned int releases[16];
+
+void
+event_isr (unsigned int id)
+{
+    unsigned char keycode = (unsigned char)EVENT_DATA(id);
+
+    if (KEYPAD_EVENT_PRESS == EVENT_TYPE(id))
+    {
+        TEST_CHECK(presses[keycode] == releases[keycode],
+            "t=%lu: key %u pressed twice", now, keycode);
+        presses[keycode]++;
+    }
+    else if (KEYPAD_EVENT_RELEASE == EVENT_TYPE(id))
+    {
+        TEST_CHECK(presses[keycode] == releases[keycode] + 1,
+            "t=%lu: key %u released without a press", now, keycode);
+        releases[keycode]++;
+    }
+}
+
+// Not part of the test.
+void input_press (unsigned char input, unsigned char key) {}
+void input_release (unsigned char input, unsigned char key) {}
+void ioc_mask_enable (unsigned char port, unsigned char mask, signed char edge) {}
+signed char isr_register (unsigned char reg, unsigned char mask, void (*isr)(void)) { return 0; }
+
+
+/** Longest bounce of the contacts, in timeout ticks. */
+#define BOUNCE_TICKS    (TIMEOUT_MS(15))
+
+/** A press of a key. */
+typedef struct
+{
+    unsigned char keycode;
+    unsigned long down;         /**< Tick the key starts making contact. */
+    unsigned long up;           /**< Tick the key starts letting go. */
+    unsigned char bounce;       /**< Ticks the contacts bounce for. */
+} press_t;
+
+/** Contacts of a key at a tick. */
+static unsigned char
+press_contact (const press_t *press)
+{
+    if ((now < press->down) || (now >= press->up + press->bounce))
+    {
+        return 0;
+    }
+
+    // Bouncing contacts are closed or open at random.
+    if ((now < press->down + press->bounce) || (now >= press->up))
+    {
+        return (unsigned char)(test_random() & 1);
+    }
+
+    return 1;
+}
+
+/** Keypad ISR runs and scans over all replays. */
+static unsigned long total_isrs = 0;
+static unsigned long total_scans = 0;
+
+/** Run the keypad through a list of presses. */
+static void
+replay (const press_t *trace, unsigned char count, unsigned long end)
+{
+    unsigned int expected[16] = {0};
+    unsigned char columns = matrix_columns();
+    unsigned long scans_max = 0;
+    unsigned long isrs = 0;
+
+    matrix_scans = 0;
+
+    for (unsigned char i = 0; i < count; i++)
+    {
+        expected[trace[i].keycode]++;
+
+        // Two scans each for going down and up, and one every hold period
+        // from going down until it has let go.
+        scans_max += 4 + (trace[i].up + trace[i].bounce - trace[i].down) / KEYPAD_HOLD_PERIOD;
+    }
+
+    for (now = 0; now < end; now++)
+    {
+        matrix_contacts = 0;
+        for (unsigned char i = 0; i < count; i++)
+        {
+            if (press_contact(&trace[i]))
+            {
+                matrix_contacts |= (unsigned int)(1U << trace[i].keycode);
+            }
+        }
+
+        // An edge on a column pin is an IOC interrupt.
+        if (columns != matrix_columns())
+        {
+            IOCCF |= (columns ^ matrix_columns()) & KEYPAD_COLUMN_MASK;
+            columns = matrix_columns();
+            keypad_isr();
+            isrs++;
+        }
+
+        if (timeout_callback && (now >= timeout_due))
+        {
+            timeout_callback_t callback = timeout_callback;
+
+            timeout_callback = 0;
+            callback();
+            columns = matrix_columns();
+        }
+    }
+
+    for (unsigned char keycode = 0; keycode < 16; keycode++)
+    {
+        TEST_CHECK(expected[keycode] == presses[keycode],
+            "key %u pressed %u times, expected %u", keycode, presses[keycode], expected[keycode]);
+        TEST_CHECK(expected[keycode] == releases[keycode],
+            "key %u released %u times, expected %u", keycode, releases[keycode], expected[keycode]);
+
+        presses[keycode] = releases[keycode] = 0;
+    }
+
+    TEST_CHECK(matrix_scans <= scans_max,
+        "%lu scans for %u presses, at most %lu expected", matrix_scans, count, scans_max);
+
+    total_isrs += isrs;
+    total_scans += matrix_scans;
+}
+
+int
+main (void)
+{
+    press_t trace[32];
+
+    keypad_init();
+
+    for (unsigned long round = 0; round < 2000; round++)
+    {
+        unsigned long t = 10;
+        unsigned long end = 0;
+        unsigned char overlap = 0;
+
+        for (unsigned char count = 0; count < 32; count++)
+        {
+            press_t *press = &trace[count];
+
+            press->keycode = (unsigned char)(test_random() % 16);
+            press->bounce = (unsigned char)(test_random() % (BOUNCE_TICKS + 1));
+            press->down = t;
+            press->up = t + press->bounce + TIMEOUT_MS(50) + test_random() % TIMEOUT_MS(200);
+
+            // A key in the same column as a held key doesn't change the column
+            // pins, it is only seen by the scans while keys are held. So keys
+            // that are down together are in different columns.
+            if (overlap && ((trace[count - 1].keycode % 4) == (press->keycode % 4)))
+            {
+                press->keycode = (unsigned char)((press->keycode + 1) % 16);
+            }
+
+            if (end < press->up + press->bounce)
+            {
+                end = press->up + press->bounce;
+            }
+
+            // Every fourth press or so, the next key goes down while this one
+            // is still held. At most two keys are down at the same time.
+            overlap = !overlap && !(test_random() % 4);
+            if (overlap)
+            {
+                t = press->down + press->bounce + TIMEOUT_MS(40);
+            }
+            else
+            {
+                t = end + TIMEOUT_MS(50) + test_random() % TIMEOUT_MS(100);
+            }
+        }
+
+        replay(trace, 32, end + TIMEOUT_MS(500));
+    }
+
+    printf("Per press: %lu.%02lu ISR runs, %lu.%02lu scans\n",
+        total_isrs / 64000, (total_isrs % 64000) * 100 / 64000,
+        total_scans / 64000, (total_scans % 64000) * 100 / 64000);
+
+    return TEST_RESULT();
+}
+
+// EOF //
@@ -0,0 +1,175 @@
+/** @file test_lcd_glyphs.c
+ *
+ * Checks the precomputed glyph maps of the LCD driver.
+ *
+ * Drawing a whole character with lcd_primary_glyph() has to give the same
+ * screen as clearing and drawing its segments one at a time, straight from
+ * the segment map of the PCB revision.
+ *
+ * It also counts the lookup table reads and read-modify-writes of the working
+ * buffer it takes to draw all 8 digits, with lcd_primary_glyph() and with the
+ * old way of calling lcd_primary_draw() or lcd_primary_clear() for each
+ * segment, and prints both.
+*/
+
+/** Work counted while drawing, see LCD_TABLE_READ() in lcd.c. */
+static unsigned long count_table_reads = 0;
+static unsigned long count_rmws = 0;
+
+#define LCD_TABLE_READ(entry)   (count_table_reads++, (entry))
+#define LCD_BUFFER_RMW()        (count_rmws++)
+
+#include "drivers/lcd.c"
+
+#include "test.h"
+
+
+/** Segment map of the primary characters, see LCD_MAP_PRIMARY_1 in lcd.c. */
+static const unsigned int reference_primary[9][7] = {
+    {0},
+    {LCD_MAP_PRIMARY_1},
+    {LCD_MAP_PRIMARY_2},
+    {LCD_MAP_PRIMARY_3},
+    {LCD_MAP_PRIMARY_4},
+    {LCD_MAP_PRIMARY_5},
+    {LCD_MAP_PRIMARY_6},
+    {LCD_MAP_PRIMARY_7},
+    {LCD_MAP_PRIMARY_8}
+};
+
+/** Draw a character into a buffer one segment at a time. */
+static void
+reference_glyph (unsigned char *buffer, unsigned char position, unsigned char segments)
+{
+    for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+    {
+        unsigned int s = reference_primary[position][segment];
+        unsigned char bit = (unsigned char)(1U << (s & 0xF));
+
+        buffer[s >> 8] &= (unsigned char)~bit;
+    }
+
+    for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+    {
+        unsigned int s = reference_primary[position][segment];
+
+        if (segments & (1U << segment))
+        {
+            buffer[s >> 8] |= (unsigned char)(1U << (s & 0xF));
+        }
+    }
+}
+
+/** Draw all 8 digits the old way, one segment at a time. */
+static void
+draw_segments (unsigned char segments)
+{
+    for (unsigned char position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+    {
+        for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+        {
+            if ((1U << segment) & segments)
+            {
+                lcd_primary_draw(position, segment);
+            }
+            else
+            {
+                lcd_primary_clear(position, segment);
+            }
+        }
+    }
+}
+
+/** Draw all 8 digits with lcd_primary_glyph(). */
+static void
+draw_glyphs (unsigned char segments)
+{
+    for (unsigned char position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+    {
+        lcd_primary_glyph(position, segments);
+    }
+}
+
+/**
+ * Count the work of drawing every glyph on all 8 digits and print the
+ * average for a screen.
+*/
+static void
+benchmark (const char *name, void (*draw)(unsigned char), unsigned long *table_reads, unsigned long *rmws)
+{
+    count_table_reads = 0;
+    count_rmws = 0;
+
+    for (unsigned int segments = 0; segments < 0x80; segments++)
+    {
+        draw((unsigned char)segments);
+    }
+
+    *table_reads = count_table_reads;
+    *rmws = count_rmws;
+
+    printf("%-12s %5lu.%lu table reads, %5lu.%lu read-modify-writes per screen\n",
+        name,
+        *table_reads / 0x80, (*table_reads % 0x80) * 10 / 0x80,
+        *rmws / 0x80, (*rmws % 0x80) * 10 / 0x80);
+}
+
+int
+main (void)
+{
+    unsigned long segments_table_reads;
+    unsigned long segments_rmws;
+    unsigned long glyphs_table_reads;
+    unsigned long glyphs_rmws;
+
+    unsigned char before[LCD_NUM_DATA_REGISTERS];
+    unsigned char expected[LCD_NUM_DATA_REGISTERS];
+
+    for (unsigned long round = 0; round < 20000; round++)
+    {
+        unsigned char position = (unsigned char)(1 + test_random() % 8);
+        unsigned char segments = (unsigned char)(test_random() & 0x7F);
+
+        // Start from whatever is on the screen.
+        for (unsigned char reg = 0; reg < LCD_NUM_DATA_REGISTERS; reg++)
+        {
+            lcd_buffer[reg] = (unsigned char)test_random();
+            before[reg] = lcd_buffer[reg];
+            expected[reg] = lcd_buffer[reg];
+        }
+        lcd_dirty[0] = lcd_dirty[1] = lcd_dirty[2] = 0;
+        lcd_ready = 1;
+
+        reference_glyph(expected, position, segments);
+        lcd_primary_glyph(position, segments);
+
+        for (unsigned char reg = 0; reg < LCD_NUM_DATA_REGISTERS; reg++)
+        {
+            unsigned char dirty = lcd_dirty[reg >> 3] & (1U << (reg & 0x07));
+
+            TEST_CHECK(expected[reg] == lcd_buffer[reg],
+                "position %u glyph 0x%02X: LCDDATA%u is 0x%02X, expected 0x%02X",
+                position, segments, reg, lcd_buffer[reg], expected[reg]);
+
+            // Every register that changed has to be written to the LCD, and
+            // the frame interrupt mustn't write a half drawn character.
+            if (before[reg] != lcd_buffer[reg])
+            {
+                TEST_CHECK(dirty && !lcd_ready,
+                    "position %u glyph 0x%02X: LCDDATA%u changed but isn't dirty",
+                    position, segments, reg);
+            }
+        }
+    }
+
+    benchmark("Per segment", &draw_segments, &segments_table_reads, &segments_rmws);
+    benchmark("Glyph", &draw_glyphs, &glyphs_table_reads, &glyphs_rmws);
+
+    // A character never takes more than one write per register it uses.
+    TEST_CHECK(glyphs_rmws < segments_rmws,
+        "glyphs take %lu read-modify-writes, segments %lu", glyphs_rmws, segments_rmws);
+
+    return TEST_RESULT();
+}
+
+// EOF //
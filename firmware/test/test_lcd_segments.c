@@ -0,0 +1,179 @@
+/** @file test_lcd_segments.c
+ *
+ * Checks the packed segment tables of the LCD driver.
+ *
+ * Every segment is drawn, cleared and blinked on its own. It has to change
+ * exactly the bit the segment map of the PCB revision gives for it.
+*/
+
+#include "drivers/lcd.c"
+
+#include "test.h"
+
+
+/** Segment maps, see LCD_MAP_PRIMARY_1 in lcd.c. */
+static const unsigned int reference_primary[9][7] = {
+    {0},
+    {LCD_MAP_PRIMARY_1},
+    {LCD_MAP_PRIMARY_2},
+    {LCD_MAP_PRIMARY_3},
+    {LCD_MAP_PRIMARY_4},
+    {LCD_MAP_PRIMARY_5},
+    {LCD_MAP_PRIMARY_6},
+    {LCD_MAP_PRIMARY_7},
+    {LCD_MAP_PRIMARY_8}
+};
+
+static const unsigned int reference_secondary[3][10] = {
+    {0},
+    {LCD_MAP_SECONDARY_1},
+    {LCD_MAP_SECONDARY_2}
+};
+
+static const unsigned int reference_periods[10] = {0, LCD_MAP_PERIODS};
+static const unsigned int reference_signs[5] = {0, LCD_MAP_SIGNS};
+static const unsigned int reference_misc[6] = {0, LCD_MAP_MISC};
+
+/** Start from a blank screen that nothing blinks on. */
+static void
+reset (void)
+{
+    for (unsigned char reg = 0; reg < LCD_NUM_DATA_REGISTERS; reg++)
+    {
+        lcd_buffer[reg] = 0;
+        lcd_blink_mask[reg] = 0;
+    }
+    lcd_dirty[0] = lcd_dirty[1] = lcd_dirty[2] = 0;
+}
+
+/**
+ * Check that a buffer holds a single segment.
+ * A segment of 0x0000 isn't on the LCD, so the buffer has to stay blank.
+*/
+static void
+check_only (volatile unsigned char *buffer, unsigned int segment, const char *name, unsigned char index)
+{
+    for (unsigned char reg = 0; reg < LCD_NUM_DATA_REGISTERS; reg++)
+    {
+        unsigned char expected = 0;
+
+        if (segment && (reg == (segment >> 8)))
+        {
+            expected = (unsigned char)(1U << (segment & 0xF));
+        }
+
+        TEST_CHECK(expected == buffer[reg],
+            "%s %u: LCDDATA%u is 0x%02X, expected 0x%02X",
+            name, index, reg, buffer[reg], expected);
+    }
+}
+
+/** Check that a buffer is blank. */
+static void
+check_blank (volatile unsigned char *buffer, const char *name, unsigned char index)
+{
+    check_only(buffer, 0x0000, name, index);
+}
+
+int
+main (void)
+{
+    unsigned char index;
+
+    for (unsigned char position = 1; position <= LCD_PRIMARY_CHARACTERS; position++)
+    {
+        for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+        {
+            index = (unsigned char)(position * 10 + segment);
+
+            reset();
+            lcd_primary_draw(position, segment);
+            check_only(lcd_buffer, reference_primary[position][segment], "primary", index);
+            lcd_primary_clear(position, segment);
+            check_blank(lcd_buffer, "primary", index);
+
+            lcd_primary_glyph(position, (unsigned char)(1U << segment));
+            check_only(lcd_buffer, reference_primary[position][segment], "primary glyph", index);
+        }
+
+        reset();
+        lcd_primary_blink(position, 1);
+        for (unsigned char segment = 0; segment < LCD_PRIMARY_CHARACTER_SEGMENTS; segment++)
+        {
+            unsigned int s = reference_primary[position][segment];
+
+            TEST_CHECK(lcd_blink_mask[s >> 8] & (1U << (s & 0xF)),
+                "primary %u: segment %u doesn't blink", position, segment);
+        }
+        lcd_primary_blink(position, 0);
+        check_blank(lcd_blink_mask, "primary blink", position);
+    }
+
+    for (unsigned char position = 1; position <= LCD_SECONDARY_CHARACTERS; position++)
+    {
+        for (unsigned char segment = 0; segment < LCD_SECONDARY_CHARACTER_SEGMENTS; segment++)
+        {
+            unsigned int s = reference_secondary[position][segment];
+
+            index = (unsigned char)(position * 10 + segment);
+
+            TEST_CHECK(!s == !(lcd_secondary_mask(position) & (1U << segment)),
+                "secondary %u: mask 0x%03X", index, lcd_secondary_mask(position));
+
+            reset();
+            lcd_secondary_draw(position, segment);
+            check_only(lcd_buffer, s, "secondary", index);
+            lcd_secondary_clear(position, segment);
+            check_blank(lcd_buffer, "secondary", index);
+        }
+
+        reset();
+        lcd_secondary_blink(position, 1);
+        for (unsigned char segment = 0; segment < LCD_SECONDARY_CHARACTER_SEGMENTS; segment++)
+        {
+            unsigned int s = reference_secondary[position][segment];
+
+            if (s)
+            {
+                TEST_CHECK(lcd_blink_mask[s >> 8] & (1U << (s & 0xF)),
+                    "secondary %u: segment %u doesn't blink", position, segment);
+                lcd_blink_mask[s >> 8] &= (unsigned char)~(1U << (s & 0xF));
+            }
+        }
+        // Missing segments mustn't blink anything else.
+        check_blank(lcd_blink_mask, "secondary blink", position);
+    }
+
+    for (index = 1; index <= 9; index++)
+    {
+        reset();
+        lcd_period_draw(index);
+        check_only(lcd_buffer, reference_periods[index], "period", index);
+        lcd_period_clear(index);
+        check_blank(lcd_buffer, "period", index);
+    }
+
+    for (index = 1; index <= 4; index++)
+    {
+        reset();
+        lcd_sign_draw(index);
+        check_only(lcd_buffer, reference_signs[index], "sign", index);
+        lcd_sign_clear(index);
+        check_blank(lcd_buffer, "sign", index);
+    }
+
+    for (index = 1; index <= 5; index++)
+    {
+        reset();
+        lcd_misc_draw(index);
+        check_only(lcd_buffer, reference_misc[index], "misc", index);
+        lcd_misc_blink(index, 1);
+        check_only(lcd_blink_mask, reference_misc[index], "misc blink", index);
+        lcd_misc_clear(index);
+        check_blank(lcd_buffer, "misc", index);
+    }
+
+    return TEST_RESULT();
+}
+
+// EOF //
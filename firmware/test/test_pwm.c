@@ -0,0 +1,103 @@
+/** @file test_pwm.c
+ *
+ * Checks the integer PWM solver against floating point.
+ *
+ * For every frequency, pwm_freq_set() and the compile time PWM_PRESCALER()
+ * and PWM_PERIOD() have to pick the lowest prescaler that fits, with the
+ * period the datasheet formula gives rounded to the nearest count. Duty
+ * cycles have to be within rounding of the exact value.
+*/
+
+#include <math.h>
+
+#include "drivers/pwm.c"
+
+#include "test.h"
+
+
+// Not part of the test.
+void timer4_init (void) {}
+
+/** Timer period of a frequency with a prescaler, before rounding. */
+static double
+reference_period (unsigned long freq, unsigned char prescaler)
+{
+    return (double)_XTAL_FREQ / 4 / freq / (1U << prescaler);
+}
+
+/**
+ * Lowest prescaler that fits a frequency.
+ *
+ * @returns     The prescaler, 8 if none fits.
+*/
+static unsigned char
+reference_prescaler (unsigned long freq)
+{
+    for (unsigned char prescaler = 0; prescaler < 8; prescaler++)
+    {
+        double period = floor(reference_period(freq, prescaler) + 0.5) - 1;
+
+        if ((0 < period) && (period < 255))
+        {
+            return prescaler;
+        }
+    }
+
+    return 8;
+}
+
+int
+main (void)
+{
+    for (unsigned long freq = 1; freq <= 0xFFFF; freq++)
+    {
+        unsigned char prescaler = reference_prescaler(freq);
+        double exact = reference_period(freq, prescaler);
+        double period = floor(exact + 0.5) - 1;
+
+        pwm_frequency = 0;
+        pwm_freq_set((unsigned int)freq);
+
+        if (8 == prescaler)
+        {
+            TEST_CHECK(0 == pwm_frequency,
+                "%lu Hz doesn't fit but was set", freq);
+            continue;
+        }
+
+        TEST_CHECK(freq == pwm_frequency,
+            "%lu Hz wasn't set", freq);
+        TEST_CHECK(prescaler == pwm_timer_prescaler,
+            "%lu Hz: prescaler %u, expected %u", freq, pwm_timer_prescaler, prescaler);
+
+        // The solver rounds in 1/256ths of a count, so it can only round the
+        // other way right next to a half.
+        TEST_CHECK((period == pwm_timer_period)
+            || (fabs(exact - floor(exact) - 0.5) < (1.0 / 256)),
+            "%lu Hz: period %u, expected %.0f", freq, pwm_timer_period, period);
+
+        TEST_CHECK(prescaler == PWM_PRESCALER(freq),
+            "%lu Hz: PWM_PRESCALER() is %u, expected %u", freq, PWM_PRESCALER(freq), prescaler);
+        TEST_CHECK(period == PWM_PERIOD(freq),
+            "%lu Hz: PWM_PERIOD() is %u, expected %.0f", freq, PWM_PERIOD(freq), period);
+
+        for (unsigned char duty = 0; duty <= 100; duty += 5)
+        {
+            // PWM4DC counts quarters of a period, PWM4DCH whole periods.
+            double quarters = 4.0 * (pwm_timer_period + 1) * duty / 100;
+            double counts = (PWM_PERIOD(freq) + 1.0) * duty / 100;
+
+            pwm_duty_set(duty);
+
+            // Rounds up from 0.52, 12/25 saves a multiplication.
+            TEST_CHECK(fabs(pwm_duty_cycle - quarters) <= 0.52,
+                "%lu Hz at %u%%: duty cycle %u, expected %.2f", freq, duty, pwm_duty_cycle, quarters);
+            TEST_CHECK(fabs(PWM_DUTY(freq, duty) - counts) <= 0.5,
+                "%lu Hz at %u%%: PWM_DUTY() is %u, expected %.2f", freq, duty, PWM_DUTY(freq, duty), counts);
+        }
+    }
+
+    return TEST_RESULT();
+}
+
+// EOF //